@@ -1,5 +1,6 @@
 #pragma once
 #include "common.h"
+#include <SDL2/SDL_mixer.h>
 
 struct Audio {
   int rate;
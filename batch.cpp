@@ -0,0 +1,117 @@
+#include "bot.h"
+#include "challenge.h"
+#include "common.h"
+#include "pool.h"
+#include "sim.h"
+
+// Input: one game per line, "<challenge> <inputs>". Inputs are either
+// "bot:<name>" (greedy, astar or hamiltonian) or a move script of U/D/L/R/.
+// letters, each optionally followed by a repeat count ("R5U2.3" = five
+// rights, two ups, three steps straight on). Blank lines and lines starting
+// with '#' are skipped.
+struct Job {
+  std::string challenge, input;
+  int score, length;
+  uint64_t steps;
+  const char *result;
+};
+
+static bool next_move(const std::string &script, size_t &pos, int &left,
+                      char &cur) {
+  if (left > 0) {
+    left--;
+    return true;
+  }
+  if (pos >= script.size())
+    return false;
+  cur = script[pos++];
+  int n = 0;
+  while (pos < script.size() && std::isdigit((unsigned char)script[pos]))
+    n = n * 10 + (script[pos++] - '0');
+  left = n > 0 ? n - 1 : 0;
+  return true;
+}
+
+static void run_job(Job &j, uint64_t max_steps) {
+  uint32_t seed;
+  int cols, rows, speed, preset;
+  bool wrap;
+  if (!parse_challenge(j.challenge, seed, cols, rows, wrap, speed, preset)) {
+    j.result = "invalid";
+    return;
+  }
+  Sim s;
+  s.reset(seed, std::clamp(cols, kMinBoard, kMaxBoard),
+          std::clamp(rows, kMinBoard, kMaxBoard), wrap,
+          std::clamp(speed, 30, 400));
+  BotKind kind = BOT_NONE;
+  if (j.input.rfind("bot:", 0) == 0 && !parse_bot(j.input.substr(4), kind)) {
+    j.result = "invalid";
+    return;
+  }
+  Bot bot;
+  bot.set(kind);
+  size_t pos = 0;
+  int left = 0;
+  char cur = '.';
+  j.result = "capped";
+  while (s.steps < max_steps) {
+    Dir d = s.dir;
+    if (kind != BOT_NONE)
+      d = bot.decide(s);
+    else if (!next_move(j.input, pos, left, cur)) {
+      j.result = "done";
+      break;
+    } else if (cur == 'U')
+      d = U;
+    else if (cur == 'D')
+      d = D;
+    else if (cur == 'L')
+      d = L;
+    else if (cur == 'R')
+      d = R;
+    if (s.step(d) == STEP_DIED) {
+      j.result = "died";
+      break;
+    }
+  }
+  j.score = s.score;
+  j.length = (int)s.snake.size();
+  j.steps = s.steps;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2 || argv[1][0] == '-') {
+    fprintf(stderr, "usage: snake_batch <file> [--threads=N] "
+                    "[--max-steps=N]\n");
+    return 2;
+  }
+  int threads = 0, max_steps = 1000000;
+  if (!argval(argc, argv, "threads").empty())
+    parse_int(argval(argc, argv, "threads"), threads);
+  if (!argval(argc, argv, "max-steps").empty())
+    parse_int(argval(argc, argv, "max-steps"), max_steps);
+  std::ifstream f(argv[1]);
+  if (!f) {
+    fprintf(stderr, "snake_batch: cannot open %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<Job> jobs;
+  std::string line;
+  while (std::getline(f, line)) {
+    std::string s = trim(line);
+    if (s.empty() || s[0] == '#')
+      continue;
+    Job j{};
+    std::stringstream ss(s);
+    ss >> j.challenge >> j.input;
+    jobs.push_back(j);
+  }
+  parallel_for(jobs.size(), (unsigned)std::max(0, threads),
+               [&](size_t i) { run_job(jobs[i], (uint64_t)max_steps); });
+  printf("challenge,score,length,steps,result\n");
+  for (auto &j : jobs)
+    printf("%s,%d,%d,%llu,%s\n", j.challenge.c_str(), j.score, j.length,
+           (unsigned long long)j.steps, j.result);
+  return 0;
+}
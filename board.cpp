@@ -0,0 +1,101 @@
+#include "board.h"
+#include <bit>
+
+Board::Board() {
+  cols = 0;
+  rows = 0;
+  free_total = 0;
+}
+
+void Board::reset(int c, int r) {
+  cols = c;
+  rows = r;
+  size_t words = ((size_t)c * r + 63) / 64;
+  wall_bits.assign(words, 0);
+  body_bits.assign(words, 0);
+  rebuild_free();
+}
+
+// Walls only ever grow within a game, so cells are added one by one and the
+// free counts adjusted in place.
+void Board::add_walls(std::span<const P> w) {
+  for (const P &p : w) {
+    if (!inside(p))
+      continue;
+    size_t i = idx(p);
+    if (test(wall_bits, i))
+      continue;
+    set(wall_bits, i);
+    if (!test(body_bits, i))
+      add_free(i >> 6, -1);
+  }
+}
+
+void Board::add_body(P p) {
+  size_t i = idx(p);
+  bool was_free = !test(wall_bits, i) && !test(body_bits, i);
+  set(body_bits, i);
+  if (was_free)
+    add_free(i >> 6, -1);
+}
+
+void Board::remove_body(P p) {
+  size_t i = idx(p);
+  if (!test(body_bits, i))
+    return;
+  clear(body_bits, i);
+  if (!test(wall_bits, i))
+    add_free(i >> 6, 1);
+}
+
+bool Board::random_free(std::mt19937 &rng, P &out) const {
+  if (free_total == 0)
+    return false;
+  std::uniform_int_distribution<size_t> d(0, free_total - 1);
+  size_t i = nth_free(d(rng));
+  out = {(int)(i % cols), (int)(i / cols)};
+  return true;
+}
+
+// Cell index of the n-th free cell in row-major order (n < free_count()).
+size_t Board::nth_free(size_t n) const {
+  size_t words = free_tree.size() - 1, pos = 0;
+  size_t step = std::bit_floor(std::max<size_t>(words, 1));
+  for (; step; step >>= 1)
+    if (pos + step <= words && free_tree[pos + step] <= n) {
+      pos += step;
+      n -= free_tree[pos];
+    }
+  uint64_t bits = free_word(pos);
+  for (; n; n--)
+    bits &= bits - 1;
+  return pos * 64 + std::countr_zero(bits);
+}
+
+uint64_t Board::free_word(size_t w) const {
+  uint64_t bits = ~(wall_bits[w] | body_bits[w]);
+  size_t n = (size_t)cols * rows;
+  if (w == n / 64 && n % 64)
+    bits &= (uint64_t(1) << (n % 64)) - 1;
+  return bits;
+}
+
+void Board::rebuild_free() {
+  size_t words = wall_bits.size();
+  free_tree.assign(words + 1, 0);
+  free_total = 0;
+  for (size_t w = 0; w < words; w++) {
+    uint32_t n = (uint32_t)std::popcount(free_word(w));
+    free_total += n;
+    free_tree[w + 1] += n;
+    size_t up = (w + 1) + ((w + 1) & (~(w + 1) + 1));
+    if (up <= words)
+      free_tree[up] += free_tree[w + 1];
+  }
+}
+
+void Board::add_free(size_t w, int delta) {
+  free_total += delta;
+  for (size_t i = w + 1; i < free_tree.size(); i += i & (~i + 1))
+    free_tree[i] += delta;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "common.h"
+#include <span>
+
+// Walls and body as bitplanes. Free cells are counted per 64-cell word in
+// a Fenwick tree, so finding the n-th free cell and updating for a body
+// move are O(log(cells / 64)) and memory stays at a few bits per cell on
+// boards of millions of cells.
+struct Board {
+  int cols, rows;
+  std::vector<uint64_t> wall_bits, body_bits;
+  std::vector<uint32_t> free_tree;
+  size_t free_total;
+
+  Board();
+  void reset(int cols, int rows);
+  bool inside(P p) const {
+    return p.x >= 0 && p.x < cols && p.y >= 0 && p.y < rows;
+  }
+  size_t idx(P p) const { return (size_t)p.y * cols + p.x; }
+  bool wall(P p) const { return test(wall_bits, idx(p)); }
+  bool body(P p) const { return test(body_bits, idx(p)); }
+  bool blocked(P p) const {
+    size_t i = idx(p);
+    return test(wall_bits, i) || test(body_bits, i);
+  }
+  void add_walls(std::span<const P> w);
+  void add_body(P p);
+  void remove_body(P p);
+  size_t free_count() const { return free_total; }
+  bool random_free(std::mt19937 &rng, P &out) const;
+  size_t nth_free(size_t n) const;
+
+  uint64_t free_word(size_t w) const;
+  void rebuild_free();
+  void add_free(size_t w, int delta);
+  static bool test(const std::vector<uint64_t> &b, size_t i) {
+    return (b[i >> 6] >> (i & 63)) & 1;
+  }
+  static void set(std::vector<uint64_t> &b, size_t i) {
+    b[i >> 6] |= uint64_t(1) << (i & 63);
+  }
+  static void clear(std::vector<uint64_t> &b, size_t i) {
+    b[i >> 6] &= ~(uint64_t(1) << (i & 63));
+  }
+};
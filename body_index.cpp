@@ -0,0 +1,32 @@
+#include "body_index.h"
+
+BodyIndex::BodyIndex() {
+  cols = rows = 0;
+  tiles_x = 0;
+  head = 0;
+}
+
+void BodyIndex::reset(int c, int r, const SnakeBody &snake) {
+  cols = c;
+  rows = r;
+  tiles_x = (c + kTile - 1) / kTile;
+  tiles.assign((size_t)tiles_x * ((r + kTile - 1) / kTile), Tile{{}, 0});
+  head = snake.head;
+  for (uint64_t q = snake.tail(); q != head + 1; q++)
+    tile(snake.at(q)).seq.push_back(q);
+}
+
+void BodyIndex::push_head(P p) { tile(p).seq.push_back(++head); }
+
+void BodyIndex::pop_tail(P p) {
+  Tile &t = tile(p);
+  t.first++;
+  // Compact once the consumed prefix outweighs the live entries.
+  if (t.first == t.seq.size()) {
+    t.seq.clear();
+    t.first = 0;
+  } else if (t.first > 32 && t.first * 2 > t.seq.size()) {
+    t.seq.erase(t.seq.begin(), t.seq.begin() + t.first);
+    t.first = 0;
+  }
+}
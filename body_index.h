@@ -0,0 +1,40 @@
+#pragma once
+#include "common.h"
+#include "snake_body.h"
+
+// Snake segments bucketed by kTile x kTile cell tiles, so drawing a large
+// board visits only the segments inside the view. Segments are named by
+// their SnakeBody sequence number, so sim.snake.at(seq) is the cell. Within a
+// tile sequence numbers are appended in order, which makes the tail always
+// the oldest entry of its tile.
+struct BodyIndex {
+  static const int kTile = 32;
+  struct Tile {
+    std::vector<uint64_t> seq;
+    size_t first;
+  };
+  int cols, rows, tiles_x;
+  std::vector<Tile> tiles;
+  uint64_t head;
+
+  BodyIndex();
+  void reset(int cols, int rows, const SnakeBody &snake);
+  void push_head(P p);
+  void pop_tail(P p);
+  Tile &tile(P p) {
+    return tiles[(size_t)(p.y / kTile) * tiles_x + p.x / kTile];
+  }
+  // Calls fn(seq) for every segment in tiles overlapping cells
+  // [x0, x1] x [y0, y1].
+  template <class F> void visit(int x0, int y0, int x1, int y1, F &&fn) const {
+    int tx0 = std::max(x0, 0) / kTile, ty0 = std::max(y0, 0) / kTile;
+    int tx1 = std::min(x1, cols - 1) / kTile,
+        ty1 = std::min(y1, rows - 1) / kTile;
+    for (int ty = ty0; ty <= ty1; ty++)
+      for (int tx = tx0; tx <= tx1; tx++) {
+        const Tile &t = tiles[(size_t)ty * tiles_x + tx];
+        for (size_t i = t.first; i < t.seq.size(); i++)
+          fn(t.seq[i]);
+      }
+  }
+};
@@ -0,0 +1,382 @@
+#include "bot.h"
+
+static P next_cell(const Sim &s, P p, Dir d) {
+  if (d == U)
+    p.y--;
+  else if (d == D)
+    p.y++;
+  else if (d == L)
+    p.x--;
+  else
+    p.x++;
+  if (s.wrap) {
+    p.x = (p.x + s.cols) % s.cols;
+    p.y = (p.y + s.rows) % s.rows;
+  }
+  return p;
+}
+
+bool parse_bot(const std::string &s, BotKind &out) {
+  if (s == "greedy")
+    out = BOT_GREEDY;
+  else if (s == "astar")
+    out = BOT_ASTAR;
+  else if (s == "hamiltonian")
+    out = BOT_HAMILTON;
+  else
+    return false;
+  return true;
+}
+
+Dir bot_greedy(const Sim &s) {
+  P h = s.snake.front();
+  Dir best = s.dir;
+  int best_d = -1;
+  for (Dir d : {s.dir, U, D, L, R}) {
+    P n = next_cell(s, h, d);
+    if (!s.board.inside(n) || s.board.blocked(n))
+      continue;
+    int dist = std::abs(n.x - s.food.x) + std::abs(n.y - s.food.y);
+    if (best_d < 0 || dist < best_d) {
+      best = d;
+      best_d = dist;
+    }
+  }
+  return best;
+}
+
+Bot::Bot() {
+  kind = BOT_NONE;
+  cols = rows = 0;
+  wrap = false;
+  stamp = body_stamp = 0;
+  last_score = hungry = 0;
+  ham_level = 0;
+  wrap_x = wrap_y = false;
+  edges_level = 0;
+  path_goal = path_at = -1;
+  aligned = false;
+  last_step = 0;
+}
+
+void Bot::set(BotKind k) {
+  kind = k;
+  cols = rows = 0;
+  path_goal = -1;
+}
+
+Dir Bot::decide(const Sim &s) {
+  if (kind == BOT_GREEDY)
+    return bot_greedy(s);
+  if (kind == BOT_ASTAR)
+    return astar(s);
+  if (kind == BOT_HAMILTON)
+    return hamilton(s);
+  return s.dir;
+}
+
+// Sizes the buffers for the board and records, for every body cell, the
+// first step at which the head may enter it: segment k (0 = head) of an n
+// long snake is gone once the tail has moved n - k times.
+void Bot::prepare(const Sim &s) {
+  if (s.cols != cols || s.rows != rows) {
+    cols = s.cols;
+    rows = s.rows;
+    size_t n = (size_t)cols * rows;
+    seen.assign(n, 0);
+    body_seen.assign(n, 0);
+    cost.assign(n, 0);
+    free_at.assign(n, 0);
+    parent.assign(n, 0);
+    stamp = body_stamp = 0;
+    ham.reset();
+    edges_level = 0;
+    path_goal = -1;
+  }
+  if (s.level != edges_level || s.wrap != wrap) {
+    wrap = s.wrap;
+    edges_level = s.level;
+    wrap_x = wrap_y = false;
+    for (int y = 0; wrap && y < rows; y++)
+      wrap_x |= !s.board.wall({0, y}) && !s.board.wall({cols - 1, y});
+    for (int x = 0; wrap && x < cols; x++)
+      wrap_y |= !s.board.wall({x, 0}) && !s.board.wall({x, rows - 1});
+  }
+  if (++body_stamp == 0) {
+    std::fill(body_seen.begin(), body_seen.end(), 0);
+    body_stamp = 1;
+  }
+  int n = (int)s.snake.size();
+  for (int k = 0; k < n; k++) {
+    const P &p = s.snake[k];
+    int c = p.y * cols + p.x;
+    body_seen[c] = body_stamp;
+    free_at[c] = n - k + 1;
+  }
+}
+
+int Bot::neighbor(int c, Dir d) const {
+  int x = c % cols, y = c / cols;
+  if (d == U)
+    y--;
+  else if (d == D)
+    y++;
+  else if (d == L)
+    x--;
+  else
+    x++;
+  if (wrap) {
+    x = (x + cols) % cols;
+    y = (y + rows) % rows;
+  }
+  if (x < 0 || x >= cols || y < 0 || y >= rows)
+    return -1;
+  return y * cols + x;
+}
+
+// Whether the head can be in cell c at step t from now.
+bool Bot::passable(const Sim &s, int c, int t) const {
+  if (c < 0 || Board::test(s.board.wall_bits, (size_t)c))
+    return false;
+  return body_seen[c] != body_stamp || free_at[c] <= t;
+}
+
+static uint32_t next_stamp(std::vector<uint32_t> &seen, uint32_t stamp) {
+  if (++stamp == 0) {
+    std::fill(seen.begin(), seen.end(), 0);
+    stamp = 1;
+  }
+  return stamp;
+}
+
+// A* from `from` to `goal` over cells that are free by the time the head
+// gets there. out receives the first move of the shortest path and `path`
+// the path itself. Distances wrap only across edges the walls leave open,
+// as an estimate through a solid border sends the search over the board.
+bool Bot::search(const Sim &s, int from, int goal, Dir &out) {
+  int gx = goal % cols, gy = goal / cols;
+  auto h = [&](int c) {
+    int dx = std::abs(c % cols - gx), dy = std::abs(c / cols - gy);
+    if (wrap_x)
+      dx = std::min(dx, cols - dx);
+    if (wrap_y)
+      dy = std::min(dy, rows - dy);
+    return dx + dy;
+  };
+  // Min-heap on (f, h) via negated keys in a max-heap. Breaking f ties
+  // towards the goal keeps open boards from expanding whole rectangles.
+  auto key = [](int f, int hn) { return -(((int64_t)f << 32) | hn); };
+  stamp = next_stamp(seen, stamp);
+  open.clear();
+  seen[from] = stamp;
+  cost[from] = 0;
+  open.push_back({key(h(from), h(from)), from});
+  while (!open.empty()) {
+    std::pop_heap(open.begin(), open.end());
+    auto [k, c] = open.back();
+    open.pop_back();
+    if (c == goal) {
+      path.clear();
+      for (; c != from; c = parent[c])
+        path.push_back(c);
+      out = step_to(from, path.back());
+      return true;
+    }
+    if ((-k >> 32) > cost[c] + h(c))
+      continue; // stale entry
+    for (Dir d : {U, D, L, R}) {
+      int n = neighbor(c, d), g = cost[c] + 1;
+      if (!passable(s, n, g) || (seen[n] == stamp && cost[n] <= g))
+        continue;
+      seen[n] = stamp;
+      cost[n] = g;
+      parent[n] = c;
+      open.push_back({key(g + h(n), h(n)), n});
+      std::push_heap(open.begin(), open.end());
+    }
+  }
+  return false;
+}
+
+// Number of cells reachable from `from`, counting up to limit.
+int Bot::room(const Sim &s, int from, int limit) {
+  stamp = next_stamp(seen, stamp);
+  queue.clear();
+  queue.push_back(from);
+  seen[from] = stamp;
+  cost[from] = 1;
+  for (size_t i = 0; i < queue.size() && (int)queue.size() < limit; i++) {
+    int c = queue[i];
+    for (Dir d : {U, D, L, R}) {
+      int n = neighbor(c, d);
+      if (!passable(s, n, cost[c] + 1) || seen[n] == stamp)
+        continue;
+      seen[n] = stamp;
+      cost[n] = cost[c] + 1;
+      queue.push_back(n);
+    }
+  }
+  return (int)queue.size();
+}
+
+// The move into the largest open area; used when the food is out of reach
+// or going for it would box the snake in.
+Dir Bot::roomiest(const Sim &s, int head) {
+  Dir best = s.dir;
+  int best_room = -1;
+  for (Dir d : {s.dir, U, D, L, R}) {
+    int n = neighbor(head, d);
+    if (opposite(d, s.dir) || !passable(s, n, 1))
+      continue;
+    int r = room(s, n, cols * rows);
+    if (r > best_room) {
+      best = d;
+      best_room = r;
+    }
+  }
+  return best;
+}
+
+// The move from cell c to its neighbour n.
+Dir Bot::step_to(int c, int n) const {
+  for (Dir d : {U, D, L, R})
+    if (neighbor(c, d) == n)
+      return d;
+  return U;
+}
+
+Dir Bot::astar(const Sim &s) {
+  prepare(s);
+  if (s.score != last_score) {
+    last_score = s.score;
+    hungry = 0;
+  }
+  hungry++;
+  P hp = s.snake.front();
+  int head = hp.y * cols + hp.x;
+  int food = s.food.x >= 0 ? s.food.y * cols + s.food.x : -1;
+  Dir d;
+  // The body only moves out of the way of a path it follows, so the last
+  // path to the food holds as long as the head is where it led and the
+  // food has not moved; the next cell is checked anyway.
+  bool kept = food >= 0 && path_goal == food && path_at == head &&
+              s.steps == last_step + 1 && !path.empty() &&
+              passable(s, path.back(), 1);
+  if (kept)
+    d = step_to(head, path.back());
+  else if (food >= 0 && search(s, head, food, d))
+    path_goal = food;
+  else
+    food = -1;
+  last_step = s.steps;
+  // A path is taken only if the snake still has room to move once on it,
+  // unless it has gone a whole board's worth of steps without eating:
+  // food in a pocket the body keeps sealing would otherwise loop forever.
+  if (food >= 0 &&
+      (hungry > cols * rows ||
+       room(s, neighbor(head, d), (int)s.snake.size() + 1) >
+           (int)s.snake.size())) {
+    path_at = path.back();
+    path.pop_back();
+    return d;
+  }
+  path_goal = -1;
+  // Following the tail keeps a way out open until the food is reachable.
+  P tp = s.snake.back();
+  if (s.snake.size() > 3 && search(s, head, tp.y * cols + tp.x, d))
+    return d;
+  return roomiest(s, head);
+}
+
+// Whether the body lies on the cycle in order: walking forward from the
+// tail reaches every segment in turn and then the head, without going all
+// the way round. Then the cells ahead of the head up to the tail are free.
+bool Bot::on_cycle(const Sim &s) const {
+  const HamCycle &h = *ham;
+  int span = 0, prev = -1;
+  for (uint64_t q = s.snake.tail(); q != s.snake.head + 1; q++) {
+    const P &p = s.snake.at(q);
+    int c = p.y * cols + p.x;
+    if (h.ord[c] < 0)
+      return false;
+    if (prev >= 0) {
+      int d = h.dist(prev, c);
+      if (d == 0)
+        return false;
+      span += d;
+    }
+    prev = c;
+  }
+  return span < h.len;
+}
+
+// Follows the cached cycle, cutting ahead along it when that cannot run
+// into the body: the skip never passes the food and leaves at least a
+// snake's length of free cycle before the tail. The check is O(1) per
+// step; the O(length) on_cycle() test runs only while the body is still
+// getting back onto the cycle after a level change or a detour.
+Dir Bot::hamilton(const Sim &s) {
+  prepare(s);
+  if (!ham || ham_level != s.level) {
+    std::shared_ptr<const HamCycle> h = ham_cycle(cols, rows, s.level);
+    if (h != ham)
+      aligned = false;
+    ham = h;
+    ham_level = s.level;
+  }
+  if (s.steps != last_step + 1)
+    aligned = false;
+  last_step = s.steps;
+  const HamCycle &h = *ham;
+  P hp = s.snake.front(), tp = s.snake.back();
+  int head = hp.y * cols + hp.x, tail = tp.y * cols + tp.x;
+  int food = s.food.x >= 0 ? s.food.y * cols + s.food.x : -1;
+  if (!aligned)
+    aligned = h.len > 0 && on_cycle(s);
+  if (food < 0 || h.ord[food] < 0) {
+    aligned = false;
+    return astar(s);
+  }
+  int len = (int)s.snake.size();
+  if (!aligned) {
+    // After a level change or a detour the body is off the cycle. Plain
+    // cycle steps lay it back down in order within one body length.
+    int n = h.ord[head] >= 0 ? h.succ[head] : -1;
+    if (n >= 0 && passable(s, n, 1) && room(s, n, len + 1) > len)
+      for (Dir d : {U, D, L, R})
+        if (neighbor(head, d) == n)
+          return d;
+    return astar(s);
+  }
+
+  int empty = h.len - len - 1;
+  int to_food = h.dist(head, food), to_tail = h.dist(head, tail);
+  int cut = to_tail - len - 3;
+  if (empty < h.len / 2)
+    cut = 0;
+  else if (to_food < to_tail) {
+    cut -= 1; // the snake grows when it eats on the way
+    if ((to_tail - to_food) * 4 > empty)
+      cut -= 10; // and the next food may appear just ahead
+  }
+  cut = std::clamp(std::min(cut, to_food), 0, h.len);
+  Dir best = s.dir;
+  int best_d = -1;
+  for (Dir d : {U, D, L, R}) {
+    int n = neighbor(head, d);
+    if (n < 0 || h.ord[n] < 0 || !passable(s, n, 1))
+      continue;
+    int dn = h.dist(head, n);
+    if (dn != 1 && dn > cut)
+      continue;
+    if (dn > best_d) {
+      best = d;
+      best_d = dn;
+    }
+  }
+  if (best_d < 0) {
+    aligned = false;
+    return astar(s);
+  }
+  return best;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "hamilton.h"
+#include "sim.h"
+
+enum BotKind { BOT_NONE, BOT_GREEDY, BOT_ASTAR, BOT_HAMILTON };
+
+bool parse_bot(const std::string &s, BotKind &out);
+Dir bot_greedy(const Sim &s);
+
+// A bot player. Search state lives in flat per-cell arrays that are sized
+// once per board and invalidated by bumping a stamp, so a decision does no
+// allocation and touches only the cells it searches.
+struct Bot {
+  BotKind kind;
+  int cols, rows;
+  bool wrap;
+  int last_score, hungry;
+  uint32_t stamp, body_stamp;
+  std::vector<uint32_t> seen, body_seen;
+  std::vector<int> cost, free_at, queue, parent;
+  std::vector<std::pair<int64_t, int>> open;
+  // Whether moves across the left/right and top/bottom edges are possible
+  // on the current layout, for the search heuristic.
+  bool wrap_x, wrap_y;
+  int edges_level;
+  // Last path found, goal first, so the next cell is path.back(). The A*
+  // bot follows a path to the food until the food moves or it is blocked.
+  std::vector<int> path;
+  int path_goal, path_at;
+  std::shared_ptr<const HamCycle> ham;
+  int ham_level;
+  bool aligned;
+  uint64_t last_step;
+
+  Bot();
+  void set(BotKind k);
+  Dir decide(const Sim &s);
+
+  void prepare(const Sim &s);
+  int neighbor(int c, Dir d) const;
+  Dir step_to(int c, int n) const;
+  bool passable(const Sim &s, int c, int t) const;
+  bool search(const Sim &s, int from, int goal, Dir &out);
+  int room(const Sim &s, int from, int limit);
+  Dir roomiest(const Sim &s, int head);
+  Dir astar(const Sim &s);
+  Dir hamilton(const Sim &s);
+  bool on_cycle(const Sim &s) const;
+};
@@ -1,11 +1,10 @@
 #pragma once
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_mixer.h>
-#include <SDL2/SDL_ttf.h>
 #include <algorithm>
 #include <cctype>
 #include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <deque>
 #include <filesystem>
@@ -19,6 +18,10 @@ struct P {
   int x, y;
 };
 enum Dir { U, D, L, R };
+inline bool opposite(Dir a, Dir b) {
+  return (a == U && b == D) || (a == D && b == U) || (a == L && b == R) ||
+         (a == R && b == L);
+}
 struct Col {
   int r, g, b;
 };
@@ -1,4 +1,7 @@
 #include "config.h"
+#include "fileio.h"
+#include <atomic>
+#include <unistd.h>
 
 std::string base_data() {
   const char *xdg = getenv("XDG_DATA_HOME");
@@ -35,12 +38,39 @@ std::string cfg_path(int profile) {
 std::string lb_path() {
   return (std::filesystem::path(base_data()) / "leaderboard.csv").string();
 }
+std::string lb_bin_path() {
+  return (std::filesystem::path(base_data()) / "leaderboard.bin").string();
+}
+std::string lb_idx_path() {
+  return (std::filesystem::path(base_data()) / "leaderboard.idx").string();
+}
 std::string lb_html_path() {
   return (std::filesystem::path(base_data()) / "leaderboard.html").string();
 }
 std::string lb_json_path() {
   return (std::filesystem::path(base_data()) / "leaderboard.json").string();
 }
+std::string replay_dir() {
+  std::filesystem::path dir = std::filesystem::path(base_data()) / "replays";
+  std::filesystem::create_directories(dir);
+  return dir.string();
+}
+std::string replay_key(uint64_t ts, uint32_t seed) {
+  return std::to_string(ts) + "-" + std::to_string(seed);
+}
+std::string replay_key_of(const std::string &file) {
+  std::string stem = std::filesystem::path(file).stem().string();
+  size_t dash = stem.find('-');
+  if (dash != std::string::npos)
+    dash = stem.find('-', dash + 1);
+  return dash == std::string::npos ? stem : stem.substr(0, dash);
+}
+std::string replay_path(uint64_t ts, uint32_t seed) {
+  static std::atomic<uint32_t> counter{0};
+  std::string name = replay_key(ts, seed) + "-" + std::to_string(getpid()) +
+                     "-" + std::to_string(counter++) + ".snrp";
+  return (std::filesystem::path(replay_dir()) / name).string();
+}
 
 void defaults(AppConfig &c) {
   c.theme.bg = {16, 16, 16};
@@ -124,9 +154,7 @@ bool load_cfg(AppConfig &c) {
 }
 
 bool save_cfg(const AppConfig &c) {
-  std::ofstream f(cfg_path(c.profile), std::ios::trunc);
-  if (!f)
-    return false;
+  std::ostringstream f;
   f << "wrap = " << (c.wrap ? "true" : "false") << "\n";
   f << "speed_ms = " << c.tick_ms << "\n";
   f << "cols = " << c.cols << "\n";
@@ -139,7 +167,8 @@ bool save_cfg(const AppConfig &c) {
   f << "food = \"" << str_hex(c.theme.food) << "\"\n";
   f << "head = \"" << str_hex(c.theme.head) << "\"\n";
   f << "body = \"" << str_hex(c.theme.body) << "\"\n";
-  return true;
+  std::string text = f.str();
+  return replace_file(cfg_path(c.profile), {text});
 }
 
 int load_highscore(int profile) {
@@ -149,8 +178,15 @@ int load_highscore(int profile) {
     f >> s;
   return s;
 }
+// Several game processes may share a profile; the file only ever moves up
+// to the best score any of them has saved.
 void save_highscore(int profile, int s) {
-  std::ofstream f(hs_path(profile), std::ios::trunc);
-  if (f)
-    f << s;
+  FileLock lock(hs_path(profile) + ".lock");
+  if (!lock.held())
+    return;
+  int cur = load_highscore(profile);
+  if (s <= cur)
+    return;
+  std::string text = std::to_string(s);
+  replace_file(hs_path(profile), {text});
 }
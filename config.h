@@ -18,8 +18,18 @@ std::string base_cfg();
 std::string hs_path(int profile);
 std::string cfg_path(int profile);
 std::string lb_path();
+std::string lb_bin_path();
+std::string lb_idx_path();
 std::string lb_html_path();
 std::string lb_json_path();
+std::string replay_dir();
+// Replays are saved as <ts>-<seed>-<pid>-<n>.snrp. The key <ts>-<seed> ties
+// a file to the leaderboard entry it backs; pid and a per-process counter
+// keep games on one seed that end in the same second from overwriting each
+// other. Several files may share a key.
+std::string replay_key(uint64_t ts, uint32_t seed);
+std::string replay_key_of(const std::string &file);
+std::string replay_path(uint64_t ts, uint32_t seed);
 
 void defaults(AppConfig &c);
 bool load_cfg(AppConfig &c);
@@ -0,0 +1,258 @@
+#include "export.h"
+#include "fileio.h"
+#include "lb_store.h"
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+
+const size_t kExportPageRows = 10000;
+static const size_t kWriteBuffer = 1 << 20;
+
+// Buffered page writer. Output goes to a temp file that is renamed into
+// place on close, so a published page is never half-written.
+struct PageWriter {
+  std::string path, tmp, buf;
+  int fd;
+  bool ok;
+
+  explicit PageWriter(const std::string &p) {
+    path = p;
+    fd = open_temp(p, tmp);
+    ok = fd >= 0;
+    buf.reserve(kWriteBuffer);
+  }
+  ~PageWriter() {
+    if (fd >= 0) {
+      ::close(fd);
+      unlink(tmp.c_str());
+    }
+  }
+  void flush() {
+    ok = ok && write_all(fd, buf.data(), buf.size());
+    buf.clear();
+  }
+  PageWriter &operator<<(std::string_view s) {
+    buf.append(s);
+    if (buf.size() >= kWriteBuffer)
+      flush();
+    return *this;
+  }
+  PageWriter &operator<<(uint64_t v) {
+    char t[24];
+    auto r = std::to_chars(t, t + sizeof(t), v);
+    return *this << std::string_view(t, r.ptr - t);
+  }
+  PageWriter &operator<<(int v) {
+    char t[16];
+    auto r = std::to_chars(t, t + sizeof(t), v);
+    return *this << std::string_view(t, r.ptr - t);
+  }
+  PageWriter &html(std::string_view s) {
+    for (char c : s) {
+      if (c == '<')
+        *this << "&lt;";
+      else if (c == '>')
+        *this << "&gt;";
+      else if (c == '&')
+        *this << "&amp;";
+      else if (c == '"')
+        *this << "&quot;";
+      else
+        buf += c;
+    }
+    return *this;
+  }
+  PageWriter &json(std::string_view s) {
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        buf += '\\';
+        buf += c;
+      } else if ((unsigned char)c < 0x20) {
+        char t[8];
+        snprintf(t, sizeof(t), "\\u%04x", c);
+        *this << t;
+      } else
+        buf += c;
+    }
+    return *this;
+  }
+  bool close() {
+    flush();
+    ok = ok && fsync(fd) == 0;
+    ::close(fd);
+    fd = -1;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+      unlink(tmp.c_str());
+      return false;
+    }
+    return true;
+  }
+};
+
+std::string lb_page_path(ExportKind kind, size_t page) {
+  if (page <= 1)
+    return kind == EXPORT_HTML ? lb_html_path() : lb_json_path();
+  std::string name = "leaderboard_" + std::to_string(page) +
+                     (kind == EXPORT_HTML ? ".html" : ".json");
+  return (std::filesystem::path(base_data()) / name).string();
+}
+
+static std::string page_name(ExportKind kind, size_t page) {
+  return std::filesystem::path(lb_page_path(kind, page)).filename().string();
+}
+
+static void html_open(PageWriter &f, uint64_t total, size_t page,
+                      size_t pages) {
+  f << "<!doctype html><html><head><meta charset=\"utf-8\"><meta "
+       "name=\"viewport\" content=\"width=device-width,initial-scale=1\">"
+    << "<title>Snake SDL2 Leaderboard</title>"
+    << "<style>body{font-family:system-ui,-apple-system,Segoe "
+       "UI,Roboto,Ubuntu,Cantarell,Noto "
+       "Sans,sans-serif;background:#0f1115;color:#e6e6e6;margin:24px}"
+    << "h1{font-size:20px;margin:0 0 "
+       "16px}table{width:100%;border-collapse:collapse;border:1px solid "
+       "#2b2f3a;border-radius:8px;overflow:hidden}"
+    << "th,td{padding:10px 12px;border-bottom:1px solid "
+       "#2b2f3a;font-size:14px;text-align:left}th{background:#171a21}tr:nth-"
+       "child(even){background:#12141a}"
+    << ".sub{color:#b0b5c0;font-size:12px}code{background:#171a21;padding:2px "
+       "6px;border-radius:6px}a{color:#8ab4f8}</style></head><body>";
+  f << "<h1>Snake SDL2 Leaderboard</h1>";
+  f << "<div class=\"sub\">Rows: " << total << " &middot; Page "
+    << (uint64_t)page << " of " << (uint64_t)pages;
+  if (page > 1)
+    f << " &middot; <a href=\"" << page_name(EXPORT_HTML, page - 1)
+      << "\">Previous</a>";
+  if (page < pages)
+    f << " &middot; <a href=\"" << page_name(EXPORT_HTML, page + 1)
+      << "\">Next</a>";
+  f << "</div>";
+  f << "<table><thead><tr><th>#</th><th>Name</th><th>Score</th><th>Profile</"
+       "th><th>Grid</th><th>Wrap</th><th>Speed</th><th>Preset</th><th>Seed</"
+       "th><th>Time</th></tr></thead><tbody>";
+}
+
+static void html_row(PageWriter &f, const LBRecord &e, uint64_t rank) {
+  f << "<tr><td>" << rank << "</td><td>";
+  f.html({e.name, strnlen(e.name, sizeof(e.name))});
+  f << "</td><td>" << e.score << "</td><td>" << e.profile << "</td>"
+    << "<td>" << e.cols << "×" << e.rows << "</td><td>"
+    << (e.wrap ? "On" : "Off") << "</td><td>" << e.speed << " ms</td>"
+    << "<td>" << e.preset << "</td><td><code>" << (uint64_t)e.seed
+    << "</code></td><td>" << e.ts << "</td></tr>";
+}
+
+static void json_open(PageWriter &f, uint64_t total, size_t page,
+                      size_t pages) {
+  f << "{\n  \"total\": " << total << ",\n  \"page\": " << (uint64_t)page
+    << ",\n  \"pages\": " << (uint64_t)pages << ",\n";
+  if (page < pages)
+    f << "  \"next\": \"" << page_name(EXPORT_JSON, page + 1) << "\",\n";
+  f << "  \"entries\": [\n";
+}
+
+static void json_row(PageWriter &f, const LBRecord &e, uint64_t rank,
+                     bool last) {
+  f << "    {\"rank\": " << rank << ", \"name\": \"";
+  f.json({e.name, strnlen(e.name, sizeof(e.name))});
+  f << "\", \"score\": " << e.score << ", \"profile\": " << e.profile
+    << ", \"seed\": " << (uint64_t)e.seed << ", \"cols\": " << e.cols
+    << ", \"rows\": " << e.rows
+    << ", \"wrap\": " << (e.wrap ? "true" : "false")
+    << ", \"speed_ms\": " << e.speed << ", \"preset\": " << e.preset
+    << ", \"timestamp\": " << e.ts << "}" << (last ? "\n" : ",\n");
+}
+
+bool export_lb(ExportKind kind, uint64_t &rows) {
+  std::unique_ptr<PageWriter> f;
+  size_t page = 0, pages = 1;
+  bool ok = true;
+  auto close_page = [&]() {
+    if (!f)
+      return;
+    if (kind == EXPORT_HTML)
+      *f << "</tbody></table></body></html>";
+    else
+      *f << "  ]\n}\n";
+    ok = f->close() && ok;
+    f.reset();
+  };
+  auto open_page = [&](uint64_t total) {
+    close_page();
+    page++;
+    f = std::make_unique<PageWriter>(lb_page_path(kind, page));
+    if (kind == EXPORT_HTML)
+      html_open(*f, total, page, pages);
+    else
+      json_open(*f, total, page, pages);
+  };
+  rows = 0;
+  bool read = lb_store_for_each(
+      [&](const LBRecord &r, uint64_t rank, uint64_t total) {
+        if (rank % kExportPageRows == 0) {
+          pages = std::max<size_t>(
+              1, (total + kExportPageRows - 1) / kExportPageRows);
+          open_page(total);
+        }
+        if (kind == EXPORT_HTML)
+          html_row(*f, r, rank + 1);
+        else
+          json_row(*f, r, rank + 1,
+                   (rank + 1) % kExportPageRows == 0 || rank + 1 == total);
+        rows++;
+      });
+  if (!read)
+    return false;
+  if (page == 0)
+    open_page(0);
+  close_page();
+  // Drop pages left over from an earlier, longer export.
+  std::error_code ec;
+  for (size_t p = page + 1;
+       std::filesystem::remove(lb_page_path(kind, p), ec); p++)
+    ;
+  return ok;
+}
+
+ExportJob::ExportJob() {
+  state = EXPORT_IDLE;
+  kind = EXPORT_HTML;
+  rows = 0;
+  ok = false;
+}
+
+ExportJob::~ExportJob() { wait(); }
+
+bool ExportJob::start(ExportKind k) {
+  if (running())
+    return false;
+  wait();
+  kind = k;
+  rows = 0;
+  ok = false;
+  state = EXPORT_RUNNING;
+  worker = std::thread([this]() {
+    uint64_t n = 0;
+    bool done = export_lb(kind, n);
+    rows = n;
+    state = done ? EXPORT_DONE : EXPORT_FAILED;
+    if (on_done)
+      on_done();
+  });
+  return true;
+}
+
+bool ExportJob::poll() {
+  int s = state.load();
+  if (s != EXPORT_DONE && s != EXPORT_FAILED)
+    return false;
+  wait();
+  ok = s == EXPORT_DONE;
+  state = EXPORT_IDLE;
+  return true;
+}
+
+void ExportJob::wait() {
+  if (worker.joinable())
+    worker.join();
+}
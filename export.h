@@ -0,0 +1,35 @@
+#pragma once
+#include "leaderboard.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+enum ExportKind { EXPORT_HTML, EXPORT_JSON };
+enum ExportState { EXPORT_IDLE, EXPORT_RUNNING, EXPORT_DONE, EXPORT_FAILED };
+
+// Full leaderboard export, split into pages of kExportPageRows rows. Page 1
+// goes to lb_html_path()/lb_json_path(), page n to leaderboard_<n>.html or
+// .json next to it.
+extern const size_t kExportPageRows;
+std::string lb_page_path(ExportKind kind, size_t page);
+bool export_lb(ExportKind kind, uint64_t &rows);
+
+// Runs export_lb() on a worker thread. The UI calls poll() once per frame;
+// it returns true exactly once when the export has finished. on_done, if
+// set, is called from the worker thread right after that so a sleeping UI
+// can be woken up.
+struct ExportJob {
+  std::thread worker;
+  std::atomic<int> state;
+  ExportKind kind;
+  uint64_t rows;
+  bool ok;
+  std::function<void()> on_done;
+
+  ExportJob();
+  ~ExportJob();
+  bool start(ExportKind k);
+  bool running() const { return state.load() == EXPORT_RUNNING; }
+  bool poll();
+  void wait();
+};
@@ -0,0 +1,67 @@
+#include "fileio.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FileLock::FileLock(const std::string &path) {
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return;
+  while (flock(fd, LOCK_EX) != 0)
+    if (errno != EINTR) {
+      ::close(fd);
+      fd = -1;
+      return;
+    }
+}
+
+FileLock::~FileLock() {
+  if (fd >= 0)
+    ::close(fd);
+}
+
+bool write_all(int fd, const void *p, size_t n) {
+  const char *c = (const char *)p;
+  while (n > 0) {
+    ssize_t w = write(fd, c, n);
+    if (w < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    c += w;
+    n -= (size_t)w;
+  }
+  return true;
+}
+
+int open_temp(const std::string &path, std::string &tmp) {
+  tmp = path + ".tmp.XXXXXX";
+  int fd = mkostemp(tmp.data(), O_CLOEXEC);
+  if (fd >= 0 && fchmod(fd, 0644) != 0) {
+    ::close(fd);
+    unlink(tmp.c_str());
+    return -1;
+  }
+  return fd;
+}
+
+bool replace_file(const std::string &path,
+                  const std::vector<std::string_view> &parts) {
+  std::string tmp;
+  int fd = open_temp(path, tmp);
+  if (fd < 0)
+    return false;
+  bool ok = true;
+  for (auto &p : parts)
+    ok = ok && write_all(fd, p.data(), p.size());
+  ok = ok && fsync(fd) == 0;
+  ::close(fd);
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
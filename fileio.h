@@ -0,0 +1,25 @@
+#pragma once
+#include "common.h"
+#include <string_view>
+
+// Exclusive advisory lock on `path` (created if missing), held for the
+// lifetime of the object. Data files are locked through a separate
+// "<file>.lock" so they can still be replaced by rename.
+struct FileLock {
+  int fd;
+  explicit FileLock(const std::string &path);
+  ~FileLock();
+  FileLock(const FileLock &) = delete;
+  FileLock &operator=(const FileLock &) = delete;
+  bool held() const { return fd >= 0; }
+};
+
+bool write_all(int fd, const void *p, size_t n);
+// Creates a uniquely named temporary file next to path for writing and
+// stores its name in tmp. Unique per call, not just per process, so
+// threads replacing the same file never share one.
+int open_temp(const std::string &path, std::string &tmp);
+// Writes parts to a temporary file next to path, fsyncs it and renames it
+// over path, so readers see either the old or the new contents.
+bool replace_file(const std::string &path,
+                  const std::vector<std::string_view> &parts);
@@ -1,78 +1,34 @@
 #include "game.h"
 
-static std::vector<P> border_walls(int cols, int rows) {
-  std::vector<P> w;
-  for (int x = 0; x < cols; x++) {
-    w.push_back({x, 0});
-    w.push_back({x, rows - 1});
-  }
-  for (int y = 0; y < rows; y++) {
-    w.push_back({0, y});
-    w.push_back({cols - 1, y});
-  }
-  return w;
-}
-static std::vector<P> level_walls(int lvl, int cols, int rows) {
-  std::vector<P> w = border_walls(cols, rows);
-  if (lvl >= 2)
-    for (int x = 6; x < cols - 6; x++)
-      w.push_back({x, rows / 2});
-  if (lvl >= 3)
-    for (int y = 4; y < rows - 4; y++)
-      w.push_back({cols / 3, y});
-  if (lvl >= 4)
-    for (int y = 4; y < rows - 4; y++)
-      w.push_back({2 * cols / 3, y});
-  if (lvl >= 5)
-    for (int x = 8; x < cols - 8; x++)
-      if ((x / 2) % 2 == 0) {
-        w.push_back({x, 5});
-        w.push_back({x, rows - 6});
-      }
-  if (lvl >= 6)
-    for (int y = 6; y < rows - 6; y++)
-      if ((y / 2) % 2 == 0) {
-        w.push_back({5, y});
-        w.push_back({cols - 6, y});
-      }
-  return w;
-}
-static std::deque<P> reset_snake(int cols, int rows) {
-  std::deque<P> s;
-  s.push_back({cols / 2, rows / 2});
-  s.push_back({cols / 2 - 1, rows / 2});
-  s.push_back({cols / 2 - 2, rows / 2});
-  return s;
-}
-static bool collides_walls(const P &q, const std::vector<P> &walls) {
-  for (auto &w : walls)
-    if (w.x == q.x && w.y == q.y)
-      return true;
-  return false;
-}
-
 Game::Game() {
   defaults(cfg);
   theme = cfg.theme;
   win = nullptr;
   ren = nullptr;
   font = nullptr;
-  dir = R;
-  next_dir = R;
-  score = 0;
+  grid_layer.tex = nullptr;
+  grid_layer.runs_cols = grid_layer.runs_rows = grid_layer.runs_level = 0;
+  max_tex_w = max_tex_h = 0;
   best = 0;
-  level = 1;
   running = true;
   paused = false;
-  over = false;
   show_settings = false;
   show_lb = false;
+  show_stats = false;
   tick_cur = cfg.tick_ms;
-  last_tick = 0;
+  perf_freq = 1000;
+  last_count = 0;
+  tick_acc = 0;
+  replay_saved = false;
+  playback = false;
+  replay_speed = 1.0;
+  over_ticks = 0;
   sel_idx = 0;
   W = 960;
   H = 720;
   last_copy_ticks = 0;
+  export_msg_ticks = 0;
+  leaderboard.keep = 20;
   presets = {{{16, 16, 16},
               {40, 40, 40},
               {220, 50, 47},
@@ -134,15 +90,15 @@ bool Game::init_from_args(int argc, char **argv) {
   }
   if (!argval(argc, argv, "cols").empty()) {
     if (parse_int(argval(argc, argv, "cols"), tmp))
-      cfg.cols = std::clamp(tmp, 8, 96);
+      cfg.cols = std::clamp(tmp, kMinBoard, kMaxBoard);
   }
   if (!argval(argc, argv, "rows").empty()) {
     if (parse_int(argval(argc, argv, "rows"), tmp))
-      cfg.rows = std::clamp(tmp, 8, 72);
+      cfg.rows = std::clamp(tmp, kMinBoard, kMaxBoard);
   }
   if (!argval(argc, argv, "speed").empty()) {
     if (parse_int(argval(argc, argv, "speed"), tmp))
-      cfg.tick_ms = std::clamp(tmp, 30, 400);
+      cfg.tick_ms = std::clamp(tmp, kMinSpeed, kMaxSpeed);
   }
   if (!argval(argc, argv, "seed").empty()) {
     long long s = 0;
@@ -166,17 +122,62 @@ bool Game::init_from_args(int argc, char **argv) {
     if (parse_challenge(argval(argc, argv, "challenge"), sd, ccols, crows,
                         cwrap, cspeed, cpreset)) {
       cfg.seed = sd;
-      cfg.cols = std::clamp(ccols, 8, 96);
-      cfg.rows = std::clamp(crows, 8, 72);
+      cfg.cols = std::clamp(ccols, kMinBoard, kMaxBoard);
+      cfg.rows = std::clamp(crows, kMinBoard, kMaxBoard);
       cfg.wrap = cwrap;
-      cfg.tick_ms = std::clamp(cspeed, 30, 400);
+      cfg.tick_ms = std::clamp(cspeed, kMinSpeed, kMaxSpeed);
       cfg.preset_idx = std::clamp(cpreset, 0, (int)presets.size() - 1);
     }
   }
+  std::string rp = argval(argc, argv, "replay");
+  if (!rp.empty()) {
+    uint32_t sd;
+    int ccols, crows, cspeed, cpreset;
+    bool cwrap;
+    if (!load_replay(rp, replay) ||
+        !parse_challenge(replay.challenge, sd, ccols, crows, cwrap, cspeed,
+                         cpreset)) {
+      fprintf(stderr, "snake: cannot read replay %s\n", rp.c_str());
+      return false;
+    }
+    if (replay.rules != kSimRules) {
+      fprintf(stderr, "snake: replay %s uses rules v%u, this build v%u\n",
+              rp.c_str(), replay.rules, kSimRules);
+      return false;
+    }
+    if (ccols < kMinBoard || ccols > kMaxBoard || crows < kMinBoard ||
+        crows > kMaxBoard) {
+      fprintf(stderr, "snake: replay %s has a %dx%d board, limit %d..%d\n",
+              rp.c_str(), ccols, crows, kMinBoard, kMaxBoard);
+      return false;
+    }
+    cfg.seed = sd;
+    cfg.cols = ccols;
+    cfg.rows = crows;
+    cfg.wrap = cwrap;
+    cfg.tick_ms = std::clamp(cspeed, kMinSpeed, kMaxSpeed);
+    cfg.preset_idx = std::clamp(cpreset, 0, (int)presets.size() - 1);
+    playback = true;
+    std::string sp = argval(argc, argv, "replay-speed");
+    if (!sp.empty()) {
+      double v = std::strtod(sp.c_str(), nullptr);
+      if (v > 0.0)
+        replay_speed = std::min(v, 1000.0);
+    }
+  }
+  std::string bk = argval(argc, argv, "bot");
+  if (!bk.empty() && !playback) {
+    BotKind k;
+    if (!parse_bot(bk, k)) {
+      fprintf(stderr, "snake: unknown bot %s (greedy, astar, hamiltonian)\n",
+              bk.c_str());
+      return false;
+    }
+    bot.set(k);
+  }
   theme = cfg.theme;
   if (cfg.preset_idx >= 0 && cfg.preset_idx < (int)presets.size())
     theme = presets[cfg.preset_idx];
-  rng.seed(cfg.seed);
   return true;
 }
 
@@ -194,6 +195,11 @@ bool Game::init_sdl() {
       win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
   if (!ren)
     return false;
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(ren, &info) == 0) {
+    max_tex_w = info.max_texture_width;
+    max_tex_h = info.max_texture_height;
+  }
   if (!audio.init())
     return false;
   font = TTF_OpenFontIndex("/usr/share/fonts/TTF/DejaVuSans.ttf", 18, 0);
@@ -202,50 +208,119 @@ bool Game::init_sdl() {
   if (!font)
     font = TTF_OpenFontIndex("/usr/share/fonts/TTF/LiberationSans-Regular.ttf",
                              18, 0);
+  text.init(ren, font);
   best = load_highscore(cfg.profile);
-  snake = reset_snake(cfg.cols, cfg.rows);
-  prev_snake = snake;
-  dir = R;
-  next_dir = R;
-  std::uniform_int_distribution<int> dx(1, cfg.cols - 2), dy(1, cfg.rows - 2);
-  walls = level_walls(level, cfg.cols, cfg.rows);
-  auto rand_cell = [&](int a, int b) {
-    std::uniform_int_distribution<int> d(a, b);
-    return d(rng);
-  };
-  while (true) {
-    P f{rand_cell(1, cfg.cols - 2), rand_cell(1, cfg.rows - 2)};
-    bool clash = false;
-    for (auto &p : snake)
-      if (p.x == f.x && p.y == f.y) {
-        clash = true;
-        break;
-      }
-    for (auto &w : walls)
-      if (w.x == f.x && w.y == f.y) {
-        clash = true;
-        break;
-      }
-    if (!clash) {
-      food = f;
-      break;
-    }
-  }
-  tick_cur = cfg.tick_ms;
-  last_tick = SDL_GetTicks();
+  new_game();
   return true;
 }
 
+void Game::new_game() {
+  save_session(now_ts());
+  // init_from_args only accepts replays start() can play; should one still
+  // be refused, a normal game is better than a half-started playback.
+  if (playback && !player.start(replay, sim))
+    playback = false;
+  if (!playback) {
+    sim.reset(cfg.seed, cfg.cols, cfg.rows, cfg.wrap, cfg.tick_ms);
+    replay.begin(make_challenge(cfg.seed, cfg.cols, cfg.rows, cfg.wrap,
+                                cfg.tick_ms, cfg.preset_idx));
+    replay_saved = false;
+  }
+  prev_body = {sim.snake.head, sim.snake.size()};
+  input.clear();
+  paused = false;
+  tick_cur = sim.tick_ms;
+  perf_freq = SDL_GetPerformanceFrequency();
+  last_count = SDL_GetPerformanceCounter();
+  tick_acc = 0;
+  body_index.reset(sim.cols, sim.rows, sim.snake);
+}
+
+// Writes the replay of the game being played, once. Finished games use the
+// leaderboard entry's timestamp so the two can be matched up for audits.
+void Game::save_session(uint64_t ts) {
+  if (playback || bot.kind != BOT_NONE || replay_saved || sim.steps == 0)
+    return;
+  replay.steps = sim.steps;
+  replay.score = sim.score;
+  save_replay(replay_path(ts, sim.seed), replay);
+  replay_saved = true;
+}
+
+Uint64 Game::tick_period() const {
+  Uint64 p = perf_freq * tick_cur / 1000;
+  if (playback)
+    p = (Uint64)((double)p / replay_speed);
+  return std::max<Uint64>(p, 1);
+}
+
+// Ticks that fall due while a frame has stalled are replayed, but no more
+// than this many in one frame; beyond that they are dropped.
+static const int kMaxCatchUp = 4;
+
+FrameStats::FrameStats() {
+  window_start = 0;
+  frames = steps = 0;
+  sum_ms = max_ms = max_late_ms = max_input_ms = 0.0;
+  fps = 0;
+  avg_ms = worst_ms = late_ms = input_ms = steps_per_frame = 0.0;
+  skipped = 0;
+}
+
+void FrameStats::frame(double ms, int n) {
+  frames++;
+  steps += n;
+  sum_ms += ms;
+  max_ms = std::max(max_ms, ms);
+}
+
+void FrameStats::late(double ms) { max_late_ms = std::max(max_late_ms, ms); }
+
+void FrameStats::input(double ms) {
+  max_input_ms = std::max(max_input_ms, ms);
+}
+
+void FrameStats::roll(Uint64 now, Uint64 freq) {
+  if (now - window_start < freq)
+    return;
+  fps = frames;
+  avg_ms = frames ? sum_ms / frames : 0.0;
+  worst_ms = max_ms;
+  late_ms = max_late_ms;
+  input_ms = max_input_ms;
+  steps_per_frame = frames ? (double)steps / frames : 0.0;
+  window_start = now;
+  frames = steps = 0;
+  sum_ms = max_ms = max_late_ms = max_input_ms = 0.0;
+}
+
+std::string FrameStats::line() const {
+  char buf[128];
+  snprintf(buf, sizeof buf,
+           "%d fps  frame %.1f/%.1f ms  late %.1f ms  input %.1f ms  "
+           "%.2f steps/frame  skipped %llu",
+           fps, avg_ms, worst_ms, late_ms, input_ms, steps_per_frame,
+           (unsigned long long)skipped);
+  return buf;
+}
+
 void Game::loop() {
   auto set_title = [&]() {
-    std::string t = "Snake SDL2 | Score: " + std::to_string(score) +
+    std::string t = "Snake SDL2 | Score: " + std::to_string(sim.score) +
                     " | Best[" + std::to_string(cfg.profile) +
                     "]: " + std::to_string(best) +
-                    " | Level: " + std::to_string(level) +
+                    " | Level: " + std::to_string(sim.level) +
                     " | Seed: " + std::to_string(cfg.seed);
     if (paused)
       t += " | Paused";
-    if (over)
+    if (bot.kind != BOT_NONE)
+      t += " | Bot";
+    if (playback) {
+      char sp[32];
+      snprintf(sp, sizeof sp, " | Replay x%g", replay_speed);
+      t += sp;
+    }
+    if (sim.over)
       t += " | Game Over (R to restart)";
     SDL_SetWindowTitle(win, t.c_str());
   };
@@ -253,375 +328,398 @@ void Game::loop() {
     if (cfg.preset_idx >= 0 && cfg.preset_idx < (int)presets.size())
       theme = presets[cfg.preset_idx];
   };
-  auto render_text = [&](const std::string &s, int x, int y, SDL_Color c) {
-    if (!font)
-      return;
-    SDL_Surface *surf = TTF_RenderUTF8_Blended(font, s.c_str(), c);
-    if (!surf)
-      return;
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(ren, surf);
-    SDL_Rect dst{x, y, surf->w, surf->h};
-    SDL_FreeSurface(surf);
-    if (tex) {
-      SDL_RenderCopy(ren, tex, nullptr, &dst);
-      SDL_DestroyTexture(tex);
-    }
-  };
-  auto rand_cell = [&](int a, int b) {
-    std::uniform_int_distribution<int> d(a, b);
-    return d(rng);
-  };
-  auto spawn_food = [&]() {
-    for (;;) {
-      P f{rand_cell(1, cfg.cols - 2), rand_cell(1, cfg.rows - 2)};
-      bool clash = false;
-      for (auto &p : snake)
-        if (p.x == f.x && p.y == f.y) {
-          clash = true;
-          break;
-        }
-      if (clash)
-        continue;
-      for (auto &w : walls)
-        if (w.x == f.x && w.y == f.y) {
-          clash = true;
-          break;
-        }
-      if (!clash) {
-        food = f;
-        return;
-      }
-    }
-  };
-  auto wrap_pos = [&](P &h) {
-    if (cfg.wrap) {
-      if (h.x < 0)
-        h.x = cfg.cols - 1;
-      if (h.x >= cfg.cols)
-        h.x = 0;
-      if (h.y < 0)
-        h.y = cfg.rows - 1;
-      if (h.y >= cfg.rows)
-        h.y = 0;
-    }
-  };
-  auto advance_level = [&]() {
-    level = 1 + score / 5;
-    if (level > 8)
-      level = 8;
-    walls = level_walls(level, cfg.cols, cfg.rows);
-  };
   auto submit_score = [&]() {
     LBEntry e;
-    e.score = score;
+    e.score = sim.score;
     e.profile = cfg.profile;
-    e.seed = cfg.seed;
-    e.cols = cfg.cols;
-    e.rows = cfg.rows;
-    e.wrap = cfg.wrap ? 1 : 0;
-    e.speed = cfg.tick_ms;
+    e.seed = sim.seed;
+    e.cols = sim.cols;
+    e.rows = sim.rows;
+    e.wrap = sim.wrap ? 1 : 0;
+    e.speed = sim.speed;
     e.preset = cfg.preset_idx;
     e.name = user_name();
     e.ts = now_ts();
-    append_lb(e);
+    // The replay goes first so a verifier never sees an entry without it.
+    save_session(e.ts);
+    leaderboard.append(e);
   };
-  set_title();
-
-  while (running) {
-    SDL_Event e;
-    while (SDL_PollEvent(&e)) {
-      if (e.type == SDL_QUIT)
-        running = false;
-      else if (e.type == SDL_KEYDOWN) {
-        SDL_Keycode k = e.key.keysym.sym;
-        if (k == SDLK_ESCAPE) {
-          if (show_lb)
-            show_lb = false;
-          else if (show_settings)
-            show_settings = false;
-          else
-            running = false;
-        } else if (k == SDLK_q) {
-          running = false;
-        } else if (k == SDLK_s) {
-          show_settings = !show_settings;
+  auto handle_event = [&](const SDL_Event &e) {
+    if (e.type == SDL_QUIT)
+      running = false;
+    else if (e.type == SDL_KEYDOWN) {
+      SDL_Keycode k = e.key.keysym.sym;
+      if (k == SDLK_ESCAPE) {
+        if (show_lb)
           show_lb = false;
-        } else if (k == SDLK_l) {
-          show_lb = !show_lb;
+        else if (show_settings)
           show_settings = false;
-        } else if (k == SDLK_c) {
-          last_challenge =
-              make_challenge(cfg.seed, cfg.cols, cfg.rows, cfg.wrap,
-                             cfg.tick_ms, cfg.preset_idx);
-          SDL_SetClipboardText(last_challenge.c_str());
-          last_copy_ticks = SDL_GetTicks();
-        } else if (k == SDLK_e) {
-          auto lb = load_lb();
-          if (export_html(lb)) {
-            std::string p = lb_html_path();
-            std::string cmd = "xdg-open \"" + p + "\" >/dev/null 2>&1 &";
-            system(cmd.c_str());
+        else
+          running = false;
+      } else if (k == SDLK_q) {
+        running = false;
+      } else if (k == SDLK_s) {
+        show_settings = !show_settings;
+        show_lb = false;
+      } else if (k == SDLK_l) {
+        show_lb = !show_lb;
+        show_settings = false;
+      } else if (k == SDLK_F3) {
+        show_stats = !show_stats;
+      } else if (k == SDLK_c) {
+        last_challenge =
+            make_challenge(cfg.seed, cfg.cols, cfg.rows, cfg.wrap,
+                           cfg.tick_ms, cfg.preset_idx);
+        SDL_SetClipboardText(last_challenge.c_str());
+        last_copy_ticks = SDL_GetTicks();
+      } else if (k == SDLK_e || k == SDLK_j) {
+        if (!exporter.start(k == SDLK_e ? EXPORT_HTML : EXPORT_JSON)) {
+          export_msg = "Export already running";
+          export_msg_ticks = SDL_GetTicks();
+        }
+      } else if (k == SDLK_n) {
+        cfg.seed = (uint32_t)std::chrono::high_resolution_clock::now()
+                       .time_since_epoch()
+                       .count();
+        new_game();
+        set_title();
+      } else if (show_settings) {
+        if (k == SDLK_UP)
+          sel_idx = (sel_idx + 11 - 1) % 11;
+        else if (k == SDLK_DOWN)
+          sel_idx = (sel_idx + 1) % 11;
+        else if (k == SDLK_RETURN || k == SDLK_SPACE) {
+          if (sel_idx == 0)
+            cfg.wrap = !cfg.wrap;
+          if (sel_idx == 3)
+            save_cfg(cfg);
+          if (sel_idx == 4) {
+            AppConfig t = cfg;
+            load_cfg(t);
+            cfg = t;
+            theme = cfg.theme;
+            apply_preset();
+          }
+          if (sel_idx == 5) {
+            defaults(cfg);
+            theme = cfg.theme;
+          }
+          if (sel_idx == 6) {
+            apply_preset();
           }
-        } else if (k == SDLK_j) {
-          auto lb = load_lb();
-          export_json(lb);
-        } else if (k == SDLK_n) {
-          cfg.seed = (uint32_t)std::chrono::high_resolution_clock::now()
-                         .time_since_epoch()
-                         .count();
-          rng.seed(cfg.seed);
-          snake = reset_snake(cfg.cols, cfg.rows);
-          prev_snake = snake;
-          dir = R;
-          next_dir = R;
-          score = 0;
-          level = 1;
-          walls = level_walls(level, cfg.cols, cfg.rows);
-          spawn_food();
-          paused = false;
-          over = false;
-          tick_cur = cfg.tick_ms;
-          last_tick = SDL_GetTicks();
-          set_title();
-        } else if (show_settings) {
-          if (k == SDLK_UP)
-            sel_idx = (sel_idx + 11 - 1) % 11;
-          else if (k == SDLK_DOWN)
-            sel_idx = (sel_idx + 1) % 11;
-          else if (k == SDLK_RETURN || k == SDLK_SPACE) {
-            if (sel_idx == 0)
-              cfg.wrap = !cfg.wrap;
-            if (sel_idx == 3)
-              save_cfg(cfg);
-            if (sel_idx == 4) {
-              AppConfig t = cfg;
-              load_cfg(t);
-              cfg = t;
-              theme = cfg.theme;
-              apply_preset();
-            }
-            if (sel_idx == 5) {
-              defaults(cfg);
-              theme = cfg.theme;
-            }
-            if (sel_idx == 6) {
-              apply_preset();
-            }
-            if (sel_idx == 9) {
-              save_cfg(cfg);
-            }
-            if (sel_idx == 10) {
-              snake = reset_snake(cfg.cols, cfg.rows);
-              prev_snake = snake;
-              dir = R;
-              next_dir = R;
-              score = 0;
-              level = 1;
-              walls = level_walls(level, cfg.cols, cfg.rows);
-              spawn_food();
-              paused = false;
-              over = false;
-              tick_cur = cfg.tick_ms;
-              last_tick = SDL_GetTicks();
-              set_title();
-            }
-          } else if (k == SDLK_LEFT) {
-            if (sel_idx == 1)
-              cfg.tick_ms = std::max(30, cfg.tick_ms - 5);
-            if (sel_idx == 2)
-              cfg.overlay_alpha = std::max(40, cfg.overlay_alpha - 10);
-            if (sel_idx == 6)
-              cfg.preset_idx =
-                  (cfg.preset_idx + (int)presets.size() - 1) % presets.size();
-          } else if (k == SDLK_RIGHT) {
-            if (sel_idx == 1)
-              cfg.tick_ms = std::min(400, cfg.tick_ms + 5);
-            if (sel_idx == 2)
-              cfg.overlay_alpha = std::min(240, cfg.overlay_alpha + 10);
-            if (sel_idx == 6)
-              cfg.preset_idx = (cfg.preset_idx + 1) % presets.size();
+          if (sel_idx == 9) {
+            save_cfg(cfg);
           }
-        } else if (k == SDLK_p && !over) {
-          paused = !paused;
-          set_title();
-        } else if (k == SDLK_r) {
-          if (score > best) {
-            best = score;
-            save_highscore(cfg.profile, best);
+          if (sel_idx == 10) {
+            new_game();
+            set_title();
           }
-          snake = reset_snake(cfg.cols, cfg.rows);
-          prev_snake = snake;
-          dir = R;
-          next_dir = R;
-          score = 0;
-          level = 1;
-          walls = level_walls(level, cfg.cols, cfg.rows);
-          spawn_food();
-          paused = false;
-          over = false;
-          tick_cur = cfg.tick_ms;
-          last_tick = SDL_GetTicks();
-          set_title();
-        } else if (!over) {
-          Dir prev = next_dir;
-          if (k == SDLK_UP && dir != D)
-            next_dir = U;
-          else if (k == SDLK_DOWN && dir != U)
-            next_dir = D;
-          else if (k == SDLK_LEFT && dir != R)
-            next_dir = L;
-          else if (k == SDLK_RIGHT && dir != L)
-            next_dir = R;
-          if (next_dir != prev && !paused)
-            Mix_PlayChannel(-1, audio.move, 0);
+        } else if (k == SDLK_LEFT) {
+          if (sel_idx == 1)
+            cfg.tick_ms = std::max(30, cfg.tick_ms - 5);
+          if (sel_idx == 2)
+            cfg.overlay_alpha = std::max(40, cfg.overlay_alpha - 10);
+          if (sel_idx == 6)
+            cfg.preset_idx =
+                (cfg.preset_idx + (int)presets.size() - 1) % presets.size();
+        } else if (k == SDLK_RIGHT) {
+          if (sel_idx == 1)
+            cfg.tick_ms = std::min(400, cfg.tick_ms + 5);
+          if (sel_idx == 2)
+            cfg.overlay_alpha = std::min(240, cfg.overlay_alpha + 10);
+          if (sel_idx == 6)
+            cfg.preset_idx = (cfg.preset_idx + 1) % presets.size();
         }
-      } else if (e.type == SDL_WINDOWEVENT &&
-                 e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
-        W = e.window.data1;
-        H = e.window.data2;
+      } else if (k == SDLK_p && !sim.over) {
+        paused = !paused;
+        set_title();
+      } else if (k == SDLK_r) {
+        if (sim.score > best) {
+          best = sim.score;
+          save_highscore(cfg.profile, best);
+        }
+        new_game();
+        set_title();
+      } else if (!sim.over && !playback && bot.kind == BOT_NONE) {
+        int d = k == SDLK_UP     ? U
+                : k == SDLK_DOWN  ? D
+                : k == SDLK_LEFT  ? L
+                : k == SDLK_RIGHT ? R
+                                  : -1;
+        if (d >= 0 &&
+            input.push((Dir)d, SDL_GetPerformanceCounter(), sim.dir) &&
+            !paused)
+          Mix_PlayChannel(-1, audio.move, 0);
       }
+    } else if (e.type == SDL_WINDOWEVENT &&
+               e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+      W = e.window.data1;
+      H = e.window.data2;
+    } else if (e.type == SDL_RENDER_TARGETS_RESET) {
+      drop_grid_layer();
+    } else if (e.type == SDL_RENDER_DEVICE_RESET) {
+      drop_grid_layer();
+      text.quit();
+      text.init(ren, font);
     }
+  };
+  set_title();
 
-    Uint32 now = SDL_GetTicks();
-    bool stepped = false;
-    if (!paused && !over && !show_settings && !show_lb &&
-        now - last_tick >= (Uint32)tick_cur) {
-      last_tick += tick_cur;
-      prev_snake = snake;
-      stepped = true;
-      dir = next_dir;
-      P head = snake.front();
-      if (dir == U)
-        head.y--;
-      else if (dir == D)
-        head.y++;
-      else if (dir == L)
-        head.x--;
-      else if (dir == R)
-        head.x++;
-      wrap_pos(head);
-      bool oob =
-          head.x < 0 || head.x >= cfg.cols || head.y < 0 || head.y >= cfg.rows;
-      if (oob || collides_walls(head, walls)) {
-        over = true;
+  // The export worker finishes while the loop may be blocked in
+  // SDL_WaitEvent; a user event wakes it so the result is shown.
+  exporter.on_done = []() {
+    SDL_Event ev{};
+    ev.type = SDL_USEREVENT;
+    SDL_PushEvent(&ev);
+  };
+  SDL_RendererInfo info;
+  bool vsync = SDL_GetRendererInfo(ren, &info) == 0 &&
+               (info.flags & SDL_RENDERER_PRESENTVSYNC);
+  bool dirty = true;
+  while (running) {
+    // While the snake is moving every frame is different; otherwise sleep
+    // until input arrives or an on-screen message is due to disappear.
+    bool playing = !paused && !sim.over && !show_settings && !show_lb &&
+                   !(playback && player.done(sim));
+    Uint32 t = SDL_GetTicks();
+    int wait = -1;
+    if (playing) {
+      Uint64 due = tick_acc + (SDL_GetPerformanceCounter() - last_count);
+      Uint64 left = due < tick_period() ? tick_period() - due : 0;
+      wait = vsync ? 0 : (int)std::min<Uint64>(left * 1000 / perf_freq, 16);
+    }
+    auto wake_at = [&](Uint32 deadline) {
+      int d = (int)(deadline - t);
+      if (d > 0)
+        wait = wait < 0 ? d : std::min(wait, d);
+    };
+    if (!last_challenge.empty())
+      wake_at(last_copy_ticks + 2000);
+    if (!export_msg.empty())
+      wake_at(export_msg_ticks + 3000);
+    if (bot.kind != BOT_NONE && sim.over)
+      wake_at(over_ticks + 2000);
+    SDL_Event e;
+    bool got = wait == 0   ? SDL_PollEvent(&e)
+               : wait < 0 ? SDL_WaitEvent(&e)
+                          : SDL_WaitEventTimeout(&e, wait);
+    if (got) {
+      handle_event(e);
+      while (SDL_PollEvent(&e))
+        handle_event(e);
+    }
+    // Any input or expired wait may have changed what is on screen.
+    if (got || wait > 0)
+      dirty = true;
+
+    if (exporter.poll()) {
+      dirty = true;
+      std::string p = lb_page_path(exporter.kind, 1);
+      if (!exporter.ok)
+        export_msg = "Export failed";
+      else
+        export_msg = "Exported " + std::to_string(exporter.rows) +
+                     " rows to " + p;
+      export_msg_ticks = SDL_GetTicks();
+      if (exporter.ok && exporter.kind == EXPORT_HTML) {
+        std::string cmd = "xdg-open \"" + p + "\" >/dev/null 2>&1 &";
+        system(cmd.c_str());
+      }
+    }
+
+    // Bot games restart on a fresh seed after a short pause (attract mode).
+    if (bot.kind != BOT_NONE && sim.over &&
+        SDL_GetTicks() - over_ticks >= 2000) {
+      cfg.seed++;
+      new_game();
+      set_title();
+      dirty = true;
+    }
+
+    // Fixed timestep: wall time accumulates only while the game was running
+    // for the whole wait, and each tick_period() of it is one step.
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 frame = now - last_count;
+    last_count = now;
+    bool live = !paused && !sim.over && !show_settings && !show_lb &&
+                !(playback && player.done(sim));
+    if (playing && live)
+      tick_acc += frame;
+    int steps = 0;
+    int max_steps =
+        kMaxCatchUp * (playback ? (int)std::ceil(replay_speed) : 1);
+    while (live && tick_acc >= tick_period()) {
+      if (steps == max_steps) {
+        frame_stats.skipped += tick_acc / tick_period();
+        tick_acc %= tick_period();
+        break;
+      }
+      frame_stats.late((double)(tick_acc - tick_period()) * 1000.0 /
+                       (double)perf_freq);
+      tick_acc -= tick_period();
+      steps++;
+      prev_body = {sim.snake.head, sim.snake.size()};
+      dirty = true;
+      Dir d = sim.dir;
+      DirInput in;
+      if (playback) {
+        d = player.dir(sim);
+      } else if (bot.kind != BOT_NONE) {
+        d = bot.decide(sim);
+      } else if (input.next(sim.dir, in)) {
+        d = in.dir;
+        frame_stats.input((double)(now - in.at) * 1000.0 /
+                          (double)perf_freq);
+        replay.turn(sim.steps, d);
+      }
+      P tail = sim.snake.back();
+      StepResult res = sim.step(d);
+      if (res != STEP_DIED)
+        body_index.push_head(sim.snake.front());
+      if (res == STEP_MOVED)
+        body_index.pop_tail(tail);
+      if (res == STEP_DIED && (playback || bot.kind != BOT_NONE)) {
         Mix_PlayChannel(-1, audio.hit, 0);
-        if (score > best) {
-          best = score;
+        over_ticks = SDL_GetTicks();
+        set_title();
+        live = false;
+      } else if (res == STEP_DIED) {
+        Mix_PlayChannel(-1, audio.hit, 0);
+        if (sim.score > best) {
+          best = sim.score;
           save_highscore(cfg.profile, best);
         }
         submit_score();
         set_title();
-      } else {
-        for (auto &p : snake)
-          if (p.x == head.x && p.y == head.y) {
-            over = true;
-            break;
-          }
-        if (over) {
-          Mix_PlayChannel(-1, audio.hit, 0);
-          if (score > best) {
-            best = score;
-            save_highscore(cfg.profile, best);
-          }
-          submit_score();
-          set_title();
-        }
-      }
-      if (!over) {
-        bool ate = (head.x == food.x && head.y == food.y);
-        snake.push_front(head);
-        if (!ate)
-          snake.pop_back();
-        else {
-          score++;
-          if (cfg.tick_ms > 30)
-            cfg.tick_ms -= 3;
-          tick_cur = cfg.tick_ms;
-          level = 1 + score / 5;
-          if (level > 8)
-            level = 8;
-          walls = level_walls(level, cfg.cols, cfg.rows);
-          spawn_food();
-          Mix_PlayChannel(-1, audio.eat, 0);
-          set_title();
-        }
+        live = false;
+      } else if (res == STEP_ATE) {
+        tick_cur = sim.tick_ms;
+        Mix_PlayChannel(-1, audio.eat, 0);
+        set_title();
       }
+      if (playback && player.done(sim))
+        live = false;
     }
-
-    double alpha = 0.0;
-    if (!paused && !over) {
-      Uint32 dt = SDL_GetTicks() - last_tick;
-      if (dt > (Uint32)tick_cur)
-        dt = tick_cur;
-      alpha = (double)dt / (double)tick_cur;
+    if (playing && live) {
+      frame_stats.frame((double)frame * 1000.0 / (double)perf_freq, steps);
+      frame_stats.roll(now, perf_freq);
     }
 
-    SDL_SetRenderDrawColor(ren, theme.bg.r, theme.bg.g, theme.bg.b, 255);
-    SDL_RenderClear(ren);
-    int cell = std::min(W / cfg.cols, H / cfg.rows);
-    if (cell < 6)
-      cell = 6;
-    int grid_w = cell * cfg.cols, grid_h = cell * cfg.rows;
-    int off_x = (W - grid_w) / 2, off_y = (H - grid_h) / 2;
+    if (!playing && !dirty)
+      continue;
+    dirty = false;
 
-    SDL_Rect r;
-    SDL_SetRenderDrawColor(ren, theme.grid.r, theme.grid.g, theme.grid.b, 255);
-    for (int y = 0; y < cfg.rows; y++)
-      for (int x = 0; x < cfg.cols; x++) {
-        r = {off_x + x * cell, off_y + y * cell, cell - 1, cell - 1};
-        SDL_RenderDrawRect(ren, &r);
-      }
-
-    SDL_SetRenderDrawColor(ren, 200, 200, 200, 255);
-    for (auto &w : walls) {
-      r = {off_x + w.x * cell + 1, off_y + w.y * cell + 1, cell - 2, cell - 2};
-      SDL_RenderFillRect(ren, &r);
-    }
-
-    SDL_SetRenderDrawColor(ren, theme.food.r, theme.food.g, theme.food.b, 255);
-    r = {off_x + food.x * cell + 1, off_y + food.y * cell + 1, cell - 2,
-         cell - 2};
-    SDL_RenderFillRect(ren, &r);
+    double alpha = 0.0;
+    if (!paused && !sim.over)
+      alpha = std::min(1.0, (double)tick_acc / (double)tick_period());
 
+    // Interpolated position of segment i (0 = head), in cells.
     auto lerp = [&](double a, double b, double t) { return a + (b - a) * t; };
-    for (size_t i = 0; i < snake.size(); ++i) {
+    const SnakeBody &snake = sim.snake;
+    auto seg_pos = [&](size_t i, double &fx, double &fy) {
       int cx = snake[i].x, cy = snake[i].y;
-      int px = (i < prev_snake.size()) ? prev_snake[i].x : cx;
-      int py = (i < prev_snake.size()) ? prev_snake[i].y : cy;
-      if (cfg.wrap) {
+      int px = cx, py = cy;
+      if (i < prev_body.len) {
+        const P &p = snake.at(prev_body.head - i);
+        px = p.x;
+        py = p.y;
+      }
+      if (sim.wrap) {
         int dx = cx - px;
         if (dx > 1)
-          px += cfg.cols;
+          px += sim.cols;
         if (dx < -1)
-          px -= cfg.cols;
+          px -= sim.cols;
         int dy = cy - py;
         if (dy > 1)
-          py += cfg.rows;
+          py += sim.rows;
         if (dy < -1)
-          py -= cfg.rows;
+          py -= sim.rows;
       }
-      double fx = lerp(px, cx, alpha), fy = lerp(py, cy, alpha);
+      fx = lerp(px, cx, alpha);
+      fy = lerp(py, cy, alpha);
       while (fx < 0)
-        fx += cfg.cols;
+        fx += sim.cols;
       while (fy < 0)
-        fy += cfg.rows;
-      while (fx >= cfg.cols)
-        fx -= cfg.cols;
-      while (fy >= cfg.rows)
-        fy -= cfg.rows;
-      int rx = off_x + (int)std::round(fx * cell) + 1,
-          ry = off_y + (int)std::round(fy * cell) + 1, rs = cell - 2;
-      if (i == 0)
-        SDL_SetRenderDrawColor(ren, theme.head.r, theme.head.g, theme.head.b,
-                               255);
-      else
-        SDL_SetRenderDrawColor(ren, theme.body.r, theme.body.g, theme.body.b,
-                               255);
-      r = {rx, ry, rs, rs};
+        fy += sim.rows;
+      while (fx >= sim.cols)
+        fx -= sim.cols;
+      while (fy >= sim.rows)
+        fy -= sim.rows;
+    };
+
+    SDL_SetRenderDrawColor(ren, theme.bg.r, theme.bg.g, theme.bg.b, 255);
+    SDL_RenderClear(ren);
+    int cell = std::min(W / sim.cols, H / sim.rows);
+    if (cell < 6)
+      cell = 6;
+    int grid_w = cell * sim.cols, grid_h = cell * sim.rows;
+    int off_x = (W - grid_w) / 2, off_y = (H - grid_h) / 2;
+    // A board that does not fit the window scrolls to keep the head
+    // centred, stopping at the board edges.
+    bool follow = grid_w > W || grid_h > H;
+    if (follow) {
+      double hx, hy;
+      seg_pos(0, hx, hy);
+      if (grid_w > W)
+        off_x = std::clamp(W / 2 - (int)((hx + 0.5) * cell), W - grid_w, 0);
+      if (grid_h > H)
+        off_y = std::clamp(H / 2 - (int)((hy + 0.5) * cell), H - grid_h, 0);
+    }
+    SDL_Rect view{std::max(off_x, 0), std::max(off_y, 0), std::min(grid_w, W),
+                  std::min(grid_h, H)};
+    int vx0 = (view.x - off_x) / cell, vy0 = (view.y - off_y) / cell;
+    int vx1 = std::min(sim.cols - 1, (view.x + view.w - 1 - off_x) / cell);
+    int vy1 = std::min(sim.rows - 1, (view.y + view.h - 1 - off_y) / cell);
+
+    SDL_Rect r;
+    if (!follow && refresh_grid_layer(cell)) {
+      r = {off_x, off_y, grid_w, grid_h};
+      SDL_RenderCopy(ren, grid_layer.tex, nullptr, &r);
+    } else
+      draw_grid_layer(off_x, off_y, cell, vx0, vy0, vx1, vy1);
+
+    const P &food = sim.food;
+    if (sim.board.inside(food)) {
+      SDL_SetRenderDrawColor(ren, theme.food.r, theme.food.g, theme.food.b,
+                             255);
+      r = {off_x + food.x * cell + 1, off_y + food.y * cell + 1, cell - 2,
+           cell - 2};
       SDL_RenderFillRect(ren, &r);
     }
 
-    if (over || show_settings || show_lb) {
+    auto seg_rect = [&](size_t i) {
+      double fx, fy;
+      seg_pos(i, fx, fy);
+      return SDL_Rect{off_x + (int)std::round(fx * cell) + 1,
+                      off_y + (int)std::round(fy * cell) + 1, cell - 2,
+                      cell - 2};
+    };
+    // The head goes first so that overlap during interpolation looks the
+    // same as it always has.
+    r = seg_rect(0);
+    SDL_SetRenderDrawColor(ren, theme.head.r, theme.head.g, theme.head.b, 255);
+    SDL_RenderFillRect(ren, &r);
+    rect_buf.clear();
+    if (follow) {
+      // Only segments in tiles around the view; one cell of margin covers
+      // segments sliding in from just outside.
+      body_index.visit(vx0 - 1, vy0 - 1, vx1 + 1, vy1 + 1, [&](uint64_t q) {
+        size_t i = (size_t)(snake.head - q);
+        if (i > 0 && i < snake.size())
+          rect_buf.push_back(seg_rect(i));
+      });
+    } else {
+      for (size_t i = 1; i < snake.size(); ++i)
+        rect_buf.push_back(seg_rect(i));
+    }
+    if (!rect_buf.empty()) {
+      SDL_SetRenderDrawColor(ren, theme.body.r, theme.body.g, theme.body.b,
+                             255);
+      SDL_RenderFillRects(ren, rect_buf.data(), (int)rect_buf.size());
+    }
+
+    if (sim.over || show_settings || show_lb) {
       SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
       SDL_SetRenderDrawColor(ren, 0, 0, 0, cfg.overlay_alpha);
       SDL_Rect overlay{0, 0, W, H};
@@ -629,7 +727,8 @@ void Game::loop() {
     }
 
     if (show_settings) {
-      int bx = off_x + 40, by = off_y + 40, bw = grid_w - 80, bh = grid_h - 80;
+      int bx = view.x + 40, by = view.y + 40, bw = view.w - 80,
+          bh = view.h - 80;
       SDL_SetRenderDrawColor(ren, 30, 30, 30, 230);
       SDL_Rect box{bx, by, bw, bh};
       SDL_RenderFillRect(ren, &box);
@@ -653,19 +752,20 @@ void Game::loop() {
           std::string("Export leaderboard HTML (E)"),
           std::string("Export leaderboard JSON (J)")};
       int y = by + 30 + 10;
-      render_text("Settings", bx + 20, by + 10, sel);
+      text.draw("Settings", bx + 20, by + 10, sel);
       for (int i = 0; i < (int)rows_txt.size(); ++i) {
-        render_text(rows_txt[i], bx + 20, y, i == sel_idx ? sel : normal);
+        text.draw(rows_txt[i], bx + 20, y, i == sel_idx ? sel : normal);
         y += 36;
       }
-      render_text("Arrows adjust, Enter/Space activate, S/Esc close, E export, "
-                  "J export JSON, L leaderboard",
-                  bx + 20, by + bh - 40, hint);
+      text.draw("Arrows adjust, Enter/Space activate, S/Esc close, E export, "
+                "J export JSON, L leaderboard",
+                bx + 20, by + bh - 40, hint);
     }
 
     if (show_lb) {
-      auto lb = load_lb();
-      int bx = off_x + 40, by = off_y + 40, bw = grid_w - 80, bh = grid_h - 80;
+      const auto &lb = leaderboard.get();
+      int bx = view.x + 40, by = view.y + 40, bw = view.w - 80,
+          bh = view.h - 80;
       SDL_SetRenderDrawColor(ren, 30, 30, 30, 230);
       SDL_Rect box{bx, by, bw, bh};
       SDL_RenderFillRect(ren, &box);
@@ -673,7 +773,7 @@ void Game::loop() {
       SDL_RenderDrawRect(ren, &box);
       SDL_Color headc{255, 255, 255, 255}, rowc{220, 220, 220, 255},
           hint{180, 180, 180, 255};
-      render_text("Leaderboard (Top 20)", bx + 20, by + 10, headc);
+      text.draw("Leaderboard (Top 20)", bx + 20, by + 10, headc);
       int show = std::min(20, (int)lb.size()), y = by + 40;
       for (int i = 0; i < show; i++) {
         const auto &e = lb[i];
@@ -682,32 +782,159 @@ void Game::loop() {
              << "  P:" << e.profile << "  " << e.cols << "x" << e.rows
              << (e.wrap ? " W" : " B") << "  " << e.speed
              << "ms  pr:" << e.preset << "  sd:" << e.seed;
-        render_text(line.str(), bx + 20, y, rowc);
+        text.draw(line.str(), bx + 20, y, rowc);
         y += 28;
       }
-      render_text("L close • E export HTML • J export JSON • C copy challenge",
-                  bx + 20, by + bh - 40, hint);
+      text.draw("L close • E export HTML • J export JSON • C copy challenge",
+                bx + 20, by + bh - 40, hint);
     }
 
     if (!last_challenge.empty()) {
       uint32_t t = SDL_GetTicks();
       if (t - last_copy_ticks < 2000) {
         SDL_Color c{255, 255, 255, 255};
-        render_text(std::string("Challenge copied: ") + last_challenge,
-                    off_x + 20, off_y + grid_h - 30, c);
+        text.draw(std::string("Challenge copied: ") + last_challenge,
+                  view.x + 20, view.y + view.h - 30, c);
       }
     }
 
+    if (exporter.running() ||
+        (!export_msg.empty() && SDL_GetTicks() - export_msg_ticks < 3000)) {
+      SDL_Color c{255, 255, 255, 255};
+      text.draw(exporter.running() ? "Exporting leaderboard..." : export_msg,
+                view.x + 20, view.y + view.h - 60, c);
+    }
+
+    if (show_stats) {
+      SDL_Color c{255, 255, 255, 255};
+      text.draw(frame_stats.line(), 10, 10, c);
+    }
+
+    text.flush();
     SDL_RenderPresent(ren);
-    if (!stepped)
-      SDL_Delay(1);
   }
 }
 
+// Draws cells [x0, x1] x [y0, y1] of the grid and walls.
+void Game::draw_grid_layer(int off_x, int off_y, int cell, int x0, int y0,
+                           int x1, int y1) {
+  // Every cell outline is cell - 1 px wide, so each row and column of cells
+  // is bounded by a pair of lines. The lines run across the 1 px gaps
+  // between cells, which are then cleared back to the background.
+  int left = off_x + x0 * cell, top = off_y + y0 * cell;
+  int w = (x1 - x0 + 1) * cell - 1, h = (y1 - y0 + 1) * cell - 1;
+  rect_buf.clear();
+  for (int x = x0; x <= x1; x++) {
+    rect_buf.push_back({off_x + x * cell, top, 1, h});
+    rect_buf.push_back({off_x + x * cell + cell - 2, top, 1, h});
+  }
+  for (int y = y0; y <= y1; y++) {
+    rect_buf.push_back({left, off_y + y * cell, w, 1});
+    rect_buf.push_back({left, off_y + y * cell + cell - 2, w, 1});
+  }
+  SDL_SetRenderDrawColor(ren, theme.grid.r, theme.grid.g, theme.grid.b, 255);
+  SDL_RenderFillRects(ren, rect_buf.data(), (int)rect_buf.size());
+  rect_buf.clear();
+  for (int x = x0; x < x1; x++)
+    rect_buf.push_back({off_x + x * cell + cell - 1, top, 1, h});
+  for (int y = y0; y < y1; y++)
+    rect_buf.push_back({left, off_y + y * cell + cell - 1, w, 1});
+  SDL_SetRenderDrawColor(ren, theme.bg.r, theme.bg.g, theme.bg.b, 255);
+  SDL_RenderFillRects(ren, rect_buf.data(), (int)rect_buf.size());
+
+  // Runs are sorted by row, so only the rows in range are visited. Each
+  // wall cell is still drawn as its own inset square.
+  refresh_wall_runs();
+  const std::vector<SDL_Rect> &runs = grid_layer.wall_runs;
+  auto it = std::lower_bound(
+      runs.begin(), runs.end(), y0,
+      [](const SDL_Rect &a, int y) { return a.y < y; });
+  rect_buf.clear();
+  for (; it != runs.end() && it->y <= y1; ++it) {
+    int a = std::max(it->x, x0), b = std::min(it->x + it->w - 1, x1);
+    for (int x = a; x <= b; x++)
+      rect_buf.push_back({off_x + x * cell + 1, off_y + it->y * cell + 1,
+                          cell - 2, cell - 2});
+  }
+  SDL_SetRenderDrawColor(ren, 200, 200, 200, 255);
+  SDL_RenderFillRects(ren, rect_buf.data(), (int)rect_buf.size());
+}
+
+void Game::refresh_wall_runs() {
+  GridLayer &g = grid_layer;
+  if (g.runs_cols == sim.cols && g.runs_rows == sim.rows &&
+      g.runs_level == sim.level)
+    return;
+  std::span<const P> lw = sim.walls->level(sim.level);
+  std::vector<P> w(lw.begin(), lw.end());
+  std::sort(w.begin(), w.end(), [](const P &a, const P &b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+  });
+  g.wall_runs.clear();
+  for (const P &p : w) {
+    SDL_Rect *last = g.wall_runs.empty() ? nullptr : &g.wall_runs.back();
+    if (last && last->y == p.y && last->x + last->w >= p.x)
+      last->w = std::max(last->w, p.x - last->x + 1);
+    else
+      g.wall_runs.push_back({p.x, p.y, 1, 1});
+  }
+  g.runs_cols = sim.cols;
+  g.runs_rows = sim.rows;
+  g.runs_level = sim.level;
+}
+
+bool Game::refresh_grid_layer(int cell) {
+  GridLayer &g = grid_layer;
+  auto same = [](Col a, Col b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+  };
+  if (g.tex && g.cell == cell && g.cols == sim.cols && g.rows == sim.rows &&
+      g.level == sim.level && same(g.bg, theme.bg) && same(g.grid, theme.grid))
+    return true;
+  if (g.tex && (g.cell != cell || g.cols != sim.cols || g.rows != sim.rows))
+    drop_grid_layer();
+  // Boards larger than the renderer's textures are drawn directly.
+  if ((max_tex_w > 0 && cell * sim.cols > max_tex_w) ||
+      (max_tex_h > 0 && cell * sim.rows > max_tex_h))
+    return false;
+  if (!g.tex) {
+    g.tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_RGBA8888,
+                              SDL_TEXTUREACCESS_TARGET, cell * sim.cols,
+                              cell * sim.rows);
+    if (!g.tex)
+      return false;
+  }
+  if (SDL_SetRenderTarget(ren, g.tex) != 0) {
+    drop_grid_layer();
+    return false;
+  }
+  SDL_SetRenderDrawColor(ren, theme.bg.r, theme.bg.g, theme.bg.b, 255);
+  SDL_RenderClear(ren);
+  draw_grid_layer(0, 0, cell, 0, 0, sim.cols - 1, sim.rows - 1);
+  SDL_SetRenderTarget(ren, nullptr);
+  g.cell = cell;
+  g.cols = sim.cols;
+  g.rows = sim.rows;
+  g.level = sim.level;
+  g.bg = theme.bg;
+  g.grid = theme.grid;
+  return true;
+}
+
+void Game::drop_grid_layer() {
+  if (grid_layer.tex)
+    SDL_DestroyTexture(grid_layer.tex);
+  grid_layer.tex = nullptr;
+}
+
 void Game::shutdown() {
-  if (score > best)
-    save_highscore(cfg.profile, score);
+  exporter.wait();
+  drop_grid_layer();
+  save_session(now_ts());
+  if (!playback && sim.score > best)
+    save_highscore(cfg.profile, sim.score);
   audio.quit();
+  text.quit();
   if (font)
     TTF_CloseFont(font);
   TTF_Quit();
@@ -1,9 +1,47 @@
 #pragma once
 #include "audio.h"
+#include "body_index.h"
+#include "bot.h"
 #include "challenge.h"
 #include "common.h"
 #include "config.h"
+#include "export.h"
+#include "input.h"
 #include "leaderboard.h"
+#include "replay.h"
+#include "sim.h"
+#include "text.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// Background, grid lines and walls pre-rendered for one board layout.
+// Walls are kept as horizontal runs in cell units sorted by row, so drawing
+// part of the board only looks at the wall cells inside it.
+struct GridLayer {
+  SDL_Texture *tex;
+  int cell, cols, rows, level;
+  Col bg, grid;
+  std::vector<SDL_Rect> wall_runs;
+  int runs_cols, runs_rows, runs_level;
+};
+
+// Frame time, tick lateness and key-to-step input latency, published once
+// per second for the F3 line.
+struct FrameStats {
+  Uint64 window_start;
+  int frames, steps;
+  double sum_ms, max_ms, max_late_ms, max_input_ms;
+  int fps;
+  double avg_ms, worst_ms, late_ms, input_ms, steps_per_frame;
+  uint64_t skipped;
+
+  FrameStats();
+  void frame(double ms, int n);
+  void late(double ms);
+  void input(double ms);
+  void roll(Uint64 now, Uint64 freq);
+  std::string line() const;
+};
 
 struct Game {
   AppConfig cfg;
@@ -11,25 +49,49 @@ struct Game {
   SDL_Window *win;
   SDL_Renderer *ren;
   TTF_Font *font;
+  TextRenderer text;
   Audio audio;
-  std::mt19937 rng;
-  std::deque<P> snake, prev_snake;
-  Dir dir, next_dir;
-  int score, best, level;
-  std::vector<P> walls;
-  P food;
-  bool running, paused, over, show_settings, show_lb;
+  Sim sim;
+  // Body head and length before the last step, for interpolation.
+  BodySnap prev_body;
+  InputQueue input;
+  int best;
+  bool running, paused, show_settings, show_lb, show_stats;
   int tick_cur;
-  Uint32 last_tick;
+  Uint64 perf_freq, last_count, tick_acc;
+  FrameStats frame_stats;
+  Replay replay;
+  bool replay_saved;
+  ReplayPlayer player;
+  bool playback;
+  double replay_speed;
+  Bot bot;
+  uint32_t over_ticks;
   int sel_idx;
   int W, H;
   std::string last_challenge;
   uint32_t last_copy_ticks;
   std::vector<Theme> presets;
+  Leaderboard leaderboard;
+  ExportJob exporter;
+  std::string export_msg;
+  uint32_t export_msg_ticks;
+  GridLayer grid_layer;
+  int max_tex_w, max_tex_h;
+  std::vector<SDL_Rect> rect_buf;
+  BodyIndex body_index;
 
   Game();
   bool init_from_args(int argc, char **argv);
   bool init_sdl();
+  void new_game();
+  void save_session(uint64_t ts);
+  Uint64 tick_period() const;
   void loop();
+  void draw_grid_layer(int off_x, int off_y, int cell, int x0, int y0, int x1,
+                       int y1);
+  bool refresh_grid_layer(int cell);
+  void refresh_wall_runs();
+  void drop_grid_layer();
   void shutdown();
 };
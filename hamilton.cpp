@@ -0,0 +1,174 @@
+#include "hamilton.h"
+#include "walls.h"
+#include <map>
+#include <mutex>
+#include <tuple>
+
+HamCycle::HamCycle() {
+  cols = rows = 0;
+  len = 0;
+}
+
+// Builds the cycle with blocks starting at cell (ox, oy).
+static std::shared_ptr<HamCycle> build(int cols, int rows,
+                                       const std::vector<uint8_t> &wall,
+                                       int ox, int oy) {
+  auto h = std::make_shared<HamCycle>();
+  h->cols = cols;
+  h->rows = rows;
+  size_t n = (size_t)cols * rows;
+  h->succ.assign(n, -1);
+  h->ord.assign(n, -1);
+
+  // Block (bx, by) covers cells x = ox + 2bx .. ox + 2bx + 1, likewise y.
+  int bw = (cols - ox) / 2, bh = (rows - oy) / 2;
+  if (bw <= 0 || bh <= 0)
+    return h;
+  auto cell = [&](int bx, int by, int dx, int dy) {
+    return (oy + 2 * by + dy) * cols + ox + 2 * bx + dx;
+  };
+  std::vector<uint8_t> open((size_t)bw * bh, 0), in_tree(open.size(), 0);
+  for (int by = 0; by < bh; by++)
+    for (int bx = 0; bx < bw; bx++)
+      open[(size_t)by * bw + bx] =
+          !wall[cell(bx, by, 0, 0)] && !wall[cell(bx, by, 1, 0)] &&
+          !wall[cell(bx, by, 0, 1)] && !wall[cell(bx, by, 1, 1)];
+
+  // The largest connected group of open blocks gets the cycle; a DFS
+  // tree gives long corridors, which leave room for shortcuts.
+  std::vector<int> comp(open.size(), -1), stack;
+  int best = -1, best_size = 0, ncomp = 0;
+  for (size_t b = 0; b < open.size(); b++) {
+    if (!open[b] || comp[b] >= 0)
+      continue;
+    int size = 0;
+    stack.assign(1, (int)b);
+    comp[b] = ncomp;
+    while (!stack.empty()) {
+      int c = stack.back();
+      stack.pop_back();
+      size++;
+      int bx = c % bw, by = c / bw;
+      int nb[4] = {bx > 0 ? c - 1 : -1, bx + 1 < bw ? c + 1 : -1,
+                   by > 0 ? c - bw : -1, by + 1 < bh ? c + bw : -1};
+      for (int x : nb)
+        if (x >= 0 && open[x] && comp[x] < 0) {
+          comp[x] = ncomp;
+          stack.push_back(x);
+        }
+    }
+    if (size > best_size) {
+      best = ncomp;
+      best_size = size;
+    }
+    ncomp++;
+  }
+  if (best < 0)
+    return h;
+
+  // Every block first circles its own four cells counter-clockwise
+  // (down the left side, right along the bottom, up, left along the top);
+  // each tree edge then reroutes two of those moves into the neighbour.
+  for (int by = 0; by < bh; by++)
+    for (int bx = 0; bx < bw; bx++) {
+      if (comp[(size_t)by * bw + bx] != best)
+        continue;
+      h->succ[cell(bx, by, 0, 0)] = cell(bx, by, 0, 1);
+      h->succ[cell(bx, by, 0, 1)] = cell(bx, by, 1, 1);
+      h->succ[cell(bx, by, 1, 1)] = cell(bx, by, 1, 0);
+      h->succ[cell(bx, by, 1, 0)] = cell(bx, by, 0, 0);
+    }
+  int root = 0;
+  while (comp[root] != best)
+    root++;
+  stack.assign(1, root);
+  in_tree[root] = 1;
+  while (!stack.empty()) {
+    int c = stack.back();
+    int bx = c % bw, by = c / bw;
+    int next = -1;
+    int nb[4] = {bx + 1 < bw ? c + 1 : -1, by + 1 < bh ? c + bw : -1,
+                 bx > 0 ? c - 1 : -1, by > 0 ? c - bw : -1};
+    for (int x : nb)
+      if (x >= 0 && comp[x] == best && !in_tree[x]) {
+        next = x;
+        break;
+      }
+    if (next < 0) {
+      stack.pop_back();
+      continue;
+    }
+    in_tree[next] = 1;
+    stack.push_back(next);
+    int ax = std::min(c, next) % bw, ay = std::min(c, next) / bw;
+    if (next == c + 1 || next == c - 1) {
+      // a left of b: a's bottom-right steps right, b's top-left steps left.
+      h->succ[cell(ax, ay, 1, 1)] = cell(ax + 1, ay, 0, 1);
+      h->succ[cell(ax + 1, ay, 0, 0)] = cell(ax, ay, 1, 0);
+    } else {
+      // a above b: a's bottom-left steps down, b's top-right steps up.
+      h->succ[cell(ax, ay, 0, 1)] = cell(ax, ay + 1, 0, 0);
+      h->succ[cell(ax, ay + 1, 1, 0)] = cell(ax, ay, 1, 1);
+    }
+  }
+
+  int start = cell(root % bw, root / bw, 0, 0), c = start, i = 0;
+  do {
+    h->ord[c] = i++;
+    c = h->succ[c];
+  } while (c != start);
+  h->len = i;
+  return h;
+}
+
+// Walls with odd gaps can cut a block grid into pieces, so all four block
+// alignments are tried and the one covering the most cells kept.
+static std::shared_ptr<const HamCycle> build(int cols, int rows,
+                                             std::span<const P> walls) {
+  std::vector<uint8_t> wall((size_t)cols * rows, 0);
+  for (const P &p : walls)
+    wall[(size_t)p.y * cols + p.x] = 1;
+  std::shared_ptr<HamCycle> best;
+  for (int oy = 0; oy < 2; oy++)
+    for (int ox = 0; ox < 2; ox++) {
+      std::shared_ptr<HamCycle> h = build(cols, rows, wall, ox, oy);
+      if (!best || h->len > best->len)
+        best = h;
+    }
+  return best;
+}
+
+// One cache slot per layout. Its mutex makes later callers wait for a build
+// in progress instead of starting their own.
+struct HamSlot {
+  std::mutex m;
+  std::weak_ptr<const HamCycle> cycle;
+};
+
+std::shared_ptr<const HamCycle> ham_cycle(int cols, int rows, int level) {
+  static std::mutex m;
+  static std::map<std::tuple<int, int, int>, std::shared_ptr<HamSlot>> cache;
+  std::shared_ptr<const WallTable> t = wall_table(cols, rows);
+  std::span<const P> walls = t->level(level);
+  std::shared_ptr<HamSlot> slot;
+  {
+    std::lock_guard<std::mutex> g(m);
+    // Slots nobody is using and whose cycle has been released go.
+    for (auto it = cache.begin(); it != cache.end();)
+      if (it->second.use_count() == 1 && it->second->cycle.expired())
+        it = cache.erase(it);
+      else
+        ++it;
+    auto &s = cache[{cols, rows, t->layout[level]}];
+    if (!s)
+      s = std::make_shared<HamSlot>();
+    slot = s;
+  }
+  std::lock_guard<std::mutex> g(slot->m);
+  std::shared_ptr<const HamCycle> h = slot->cycle.lock();
+  if (!h) {
+    h = build(cols, rows, walls);
+    slot->cycle = h;
+  }
+  return h;
+}
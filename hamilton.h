@@ -0,0 +1,21 @@
+#pragma once
+#include "common.h"
+#include <memory>
+
+// A cycle through the free cells of one wall layout. The board is cut into
+// 2x2 blocks; a spanning tree over the largest connected group of wall-free
+// blocks is traced around, which visits all four cells of every block in
+// the tree exactly once. Cells outside those blocks have ord == -1.
+struct HamCycle {
+  int cols, rows;
+  std::vector<int> succ, ord;
+  int len;
+
+  HamCycle();
+  int dist(int a, int b) const { return (ord[b] - ord[a] + len) % len; }
+};
+
+// Cycles are built once per wall layout and shared while anyone holds them;
+// levels with the same walls share a cycle. The cache keeps only weak
+// references, so a cycle is freed once its last bot lets go.
+std::shared_ptr<const HamCycle> ham_cycle(int cols, int rows, int level);
@@ -0,0 +1,31 @@
+#include "input.h"
+
+InputQueue::InputQueue() { clear(); }
+
+void InputQueue::clear() {
+  head = 0;
+  count = 0;
+}
+
+// Accepts d if it turns relative to the last queued direction (or cur when
+// nothing is queued). Repeats, reversals and presses past kLen are dropped.
+bool InputQueue::push(Dir d, uint64_t at, Dir cur) {
+  Dir last = count ? buf[(head + count - 1) % kLen].dir : cur;
+  if (count == kLen || d == last || opposite(d, last))
+    return false;
+  buf[(head + count) % kLen] = {d, at};
+  count++;
+  return true;
+}
+
+// Pops the next turn that is still valid for the direction actually applied.
+bool InputQueue::next(Dir cur, DirInput &out) {
+  while (count) {
+    out = buf[head];
+    head = (head + 1) % kLen;
+    count--;
+    if (out.dir != cur && !opposite(out.dir, cur))
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "common.h"
+
+// A turn the player asked for, with the performance counter at the key
+// press.
+struct DirInput {
+  Dir dir;
+  uint64_t at;
+};
+
+// Turns pressed faster than the game ticks. Each step consumes one, so Up
+// then Left within a tick becomes two turns instead of the last one winning.
+struct InputQueue {
+  static const int kLen = 4;
+  DirInput buf[kLen];
+  int head, count;
+
+  InputQueue();
+  void clear();
+  bool push(Dir d, uint64_t at, Dir cur);
+  bool next(Dir cur, DirInput &out);
+};
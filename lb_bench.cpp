@@ -0,0 +1,71 @@
+#include "lb_store.h"
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Append throughput of the shared leaderboard store under N concurrent
+// writer processes. Runs in a scratch XDG_DATA_HOME and checks afterwards
+// that every record arrived intact.
+static double run(int writers, int appends) {
+  std::filesystem::remove(lb_bin_path());
+  std::filesystem::remove(lb_idx_path());
+  auto t0 = std::chrono::steady_clock::now();
+  for (int w = 0; w < writers; w++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      LBEntry e{0, 1, 0, 32, 24, 0, 120, 0, "w" + std::to_string(w), 0};
+      for (int i = 0; i < appends; i++) {
+        e.score = i;
+        e.seed = (uint32_t)w;
+        e.ts = now_ts();
+        if (!lb_store_append(e))
+          _exit(1);
+      }
+      _exit(0);
+    }
+  }
+  bool ok = true;
+  for (int w = 0; w < writers; w++) {
+    int st = 0;
+    wait(&st);
+    ok = ok && WIFEXITED(st) && WEXITSTATUS(st) == 0;
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             t0)
+                   .count();
+  auto all = lb_store_top((size_t)writers * appends + 1);
+  std::vector<int> seen(writers, 0);
+  for (auto &e : all)
+    if ((int)e.seed < writers && e.name == "w" + std::to_string(e.seed))
+      seen[e.seed]++;
+  for (int w = 0; w < writers; w++)
+    ok = ok && seen[w] == appends;
+  if (!ok || (int)all.size() != writers * appends) {
+    fprintf(stderr, "lb_bench: %d writers lost or corrupted records\n",
+            writers);
+    return -1;
+  }
+  return writers * appends / sec;
+}
+
+int main(int argc, char **argv) {
+  int appends = 2000, max_writers = 8;
+  if (!argval(argc, argv, "appends").empty())
+    parse_int(argval(argc, argv, "appends"), appends);
+  if (!argval(argc, argv, "writers").empty())
+    parse_int(argval(argc, argv, "writers"), max_writers);
+  char dir[] = "/tmp/snake_lb_bench.XXXXXX";
+  if (!mkdtemp(dir))
+    return 1;
+  setenv("XDG_DATA_HOME", dir, 1);
+  printf("writers,appends,appends_per_sec\n");
+  int rc = 0;
+  for (int w = 1; w <= max_writers; w *= 2) {
+    double rate = run(w, appends);
+    if (rate < 0)
+      rc = 1;
+    printf("%d,%d,%.0f\n", w, w * appends, rate);
+    fflush(stdout);
+  }
+  std::filesystem::remove_all(dir);
+  return rc;
+}
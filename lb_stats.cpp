@@ -0,0 +1,184 @@
+#include "lb_store.h"
+#include "pool.h"
+#include <map>
+#include <unordered_map>
+
+// Offline leaderboard aggregates. Reads leaderboard.bin (default) or a
+// leaderboard.csv given on the command line, splits it into chunks that
+// are aggregated on all cores and merged, and prints CSV sections.
+struct Dist {
+  // Count per distinct score. Scores are client-submitted and may be huge
+  // or negative, so the histogram is sparse.
+  std::map<int, uint64_t> hist;
+  uint64_t n = 0;
+  double sum = 0;
+
+  void add(int score) {
+    hist[score]++;
+    n++;
+    sum += score;
+  }
+  void merge(const Dist &o) {
+    for (auto &[s, c] : o.hist)
+      hist[s] += c;
+    n += o.n;
+    sum += o.sum;
+  }
+  int min() const { return hist.empty() ? 0 : hist.begin()->first; }
+  int max() const { return hist.empty() ? 0 : hist.rbegin()->first; }
+  int percentile(double p) const {
+    uint64_t want = std::max<uint64_t>((uint64_t)std::ceil(p * n), 1), seen = 0;
+    for (auto &[s, c] : hist) {
+      seen += c;
+      if (seen >= want)
+        return s;
+    }
+    return max();
+  }
+};
+
+struct Stats {
+  Dist all;
+  std::map<int, Dist> profile, wrap, speed;
+  std::map<std::pair<int, int>, Dist> grid;
+  std::unordered_map<uint32_t, int> seeds; // best score per seed
+
+  void best(uint32_t seed, int score) {
+    auto [it, fresh] = seeds.try_emplace(seed, score);
+    if (!fresh)
+      it->second = std::max(it->second, score);
+  }
+  void add(const LBEntry &e) {
+    all.add(e.score);
+    profile[e.profile].add(e.score);
+    wrap[e.wrap ? 1 : 0].add(e.score);
+    speed[e.speed].add(e.score);
+    grid[{e.cols, e.rows}].add(e.score);
+    best(e.seed, e.score);
+  }
+  void merge(const Stats &o) {
+    all.merge(o.all);
+    for (auto &[k, d] : o.profile)
+      profile[k].merge(d);
+    for (auto &[k, d] : o.wrap)
+      wrap[k].merge(d);
+    for (auto &[k, d] : o.speed)
+      speed[k].merge(d);
+    for (auto &[k, d] : o.grid)
+      grid[k].merge(d);
+    for (auto &[seed, score] : o.seeds)
+      best(seed, score);
+  }
+};
+
+static void print_row(const std::string &key, const Dist &d) {
+  printf("%s,%llu,%.2f,%d,%d,%d,%d,%d\n", key.c_str(),
+         (unsigned long long)d.n, d.n ? d.sum / d.n : 0.0,
+         d.min(), d.percentile(0.5), d.percentile(0.9), d.percentile(0.99),
+         d.max());
+}
+
+static void print_section(const char *name, const std::map<int, Dist> &m) {
+  printf("\n# %s\n%s,count,mean,min,p50,p90,p99,max\n", name, name);
+  for (auto &[k, d] : m)
+    print_row(std::to_string(k), d);
+}
+
+int main(int argc, char **argv) {
+  int threads = 0, top_seeds = 20;
+  if (!argval(argc, argv, "threads").empty())
+    parse_int(argval(argc, argv, "threads"), threads);
+  if (!argval(argc, argv, "top-seeds").empty())
+    parse_int(argval(argc, argv, "top-seeds"), top_seeds);
+  std::string csv;
+  for (int i = 1; i < argc; i++)
+    if (argv[i][0] != '-')
+      csv = argv[i];
+
+  unsigned workers =
+      threads > 0 ? (unsigned)threads
+                  : std::max(1u, std::thread::hardware_concurrency());
+  size_t chunks = (size_t)workers * 8;
+  std::vector<Stats> part(chunks);
+  MappedFile f;
+  LBStoreView store;
+  if (!csv.empty()) {
+    if (!f.open(csv)) {
+      fprintf(stderr, "snake_lb_stats: cannot open %s\n", csv.c_str());
+      return 1;
+    }
+    std::string_view data = f.view();
+    // Chunk i owns every line that starts in [lo, hi).
+    auto line_start = [&](size_t pos) {
+      if (pos == 0 || pos >= data.size())
+        return std::min(pos, data.size());
+      size_t nl = data.find('\n', pos - 1);
+      return nl == std::string_view::npos ? data.size() : nl + 1;
+    };
+    parallel_for(chunks, workers, [&](size_t c) {
+      size_t lo = line_start(data.size() * c / chunks),
+             hi = line_start(data.size() * (c + 1) / chunks);
+      std::string_view name;
+      LBEntry e{};
+      while (lo < hi) {
+        size_t nl = data.find('\n', lo);
+        size_t end = nl == std::string_view::npos ? data.size() : nl;
+        if (parse_lb_fields(data.substr(lo, end - lo), e, name))
+          part[c].add(e);
+        lo = end + 1;
+      }
+    });
+  } else {
+    lb_store_migrate();
+    if (!store.open()) {
+      fprintf(stderr, "snake_lb_stats: cannot read %s\n",
+              lb_bin_path().c_str());
+      return 1;
+    }
+    parallel_for(chunks, workers, [&](size_t c) {
+      uint64_t lo = store.count * c / chunks,
+               hi = store.count * (c + 1) / chunks;
+      for (uint64_t i = lo; i < hi; i++) {
+        const LBRecord &r = store.recs[i];
+        LBEntry e{r.score, r.profile, r.seed, r.cols, r.rows,
+                  r.wrap,  r.speed,   r.preset, {},  r.ts};
+        part[c].add(e);
+      }
+    });
+  }
+
+  // Pairwise tree merge so the merge also runs in parallel.
+  for (size_t step = 1; step < chunks; step *= 2)
+    parallel_for((chunks + 2 * step - 1) / (2 * step), workers, [&](size_t i) {
+      size_t a = i * 2 * step, b = a + step;
+      if (b < chunks) {
+        part[a].merge(part[b]);
+        part[b] = Stats();
+      }
+    });
+  Stats &s = part[0];
+
+  printf("# overall\ngroup,count,mean,min,p50,p90,p99,max\n");
+  print_row("all", s.all);
+  print_section("profile", s.profile);
+  printf("\n# grid\ngrid,count,mean,min,p50,p90,p99,max\n");
+  for (auto &[k, d] : s.grid)
+    print_row(std::to_string(k.first) + "x" + std::to_string(k.second), d);
+  print_section("wrap", s.wrap);
+  print_section("speed", s.speed);
+
+  // Seeds ordered by best score.
+  std::vector<std::pair<uint32_t, int>> seeds(s.seeds.begin(), s.seeds.end());
+  size_t distinct = seeds.size();
+  std::sort(seeds.begin(), seeds.end(), [](auto &a, auto &b) {
+    if (a.second != b.second)
+      return a.second > b.second;
+    return a.first < b.first;
+  });
+  if (top_seeds > 0 && seeds.size() > (size_t)top_seeds)
+    seeds.resize(top_seeds);
+  printf("\n# seed_best (%zu distinct seeds)\nseed,best\n", distinct);
+  for (auto &[seed, best] : seeds)
+    printf("%u,%d\n", seed, best);
+  return 0;
+}
@@ -0,0 +1,258 @@
+#include "lb_store.h"
+#include "fileio.h"
+#include "mapped_file.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint32_t kStoreVersion = 1;
+// Appended records scanned linearly before a read rebuilds the index.
+static const uint64_t kMaxUnindexed = 4096;
+
+LBRecord lb_to_record(const LBEntry &e) {
+  LBRecord r;
+  std::memset(&r, 0, sizeof(r));
+  r.score = e.score;
+  r.profile = e.profile;
+  r.seed = e.seed;
+  r.cols = e.cols;
+  r.rows = e.rows;
+  r.wrap = e.wrap;
+  r.speed = e.speed;
+  r.preset = e.preset;
+  r.ts = e.ts;
+  // A name that does not fit is cut at a character boundary, never inside
+  // a UTF-8 sequence.
+  size_t n = std::min(e.name.size(), sizeof(r.name) - 1);
+  if (n < e.name.size())
+    while (n > 0 && ((unsigned char)e.name[n] & 0xc0) == 0x80)
+      n--;
+  std::memcpy(r.name, e.name.data(), n);
+  return r;
+}
+
+static std::string_view record_name(const LBRecord &r) {
+  return {r.name, strnlen(r.name, sizeof(r.name))};
+}
+
+LBEntry lb_from_record(const LBRecord &r) {
+  LBEntry e;
+  e.score = r.score;
+  e.profile = r.profile;
+  e.seed = r.seed;
+  e.cols = r.cols;
+  e.rows = r.rows;
+  e.wrap = r.wrap;
+  e.speed = r.speed;
+  e.preset = r.preset;
+  e.name.assign(record_name(r));
+  e.ts = r.ts;
+  return e;
+}
+
+static bool record_before(const LBRecord &a, const LBRecord &b) {
+  if (a.score != b.score)
+    return a.score > b.score;
+  return a.ts < b.ts;
+}
+
+bool LBStoreView::open() {
+  recs = nullptr;
+  count = 0;
+  id = 0;
+  if (!file.open(lb_bin_path()))
+    return false;
+  if (file.size < sizeof(LBFileHeader))
+    return file.size == 0;
+  LBFileHeader h;
+  std::memcpy(&h, file.data, sizeof(h));
+  if (std::memcmp(h.magic, "SNLB", 4) != 0 || h.version != kStoreVersion ||
+      h.record_size != sizeof(LBRecord))
+    return false;
+  id = h.store_id;
+  recs = (const LBRecord *)(file.data + sizeof(LBFileHeader));
+  count = (file.size - sizeof(LBFileHeader)) / sizeof(LBRecord);
+  return true;
+}
+
+static LBFileHeader file_header() {
+  LBFileHeader h;
+  std::memcpy(h.magic, "SNLB", 4);
+  h.version = kStoreVersion;
+  h.record_size = sizeof(LBRecord);
+  h.store_id = std::random_device{}();
+  return h;
+}
+
+static std::string_view bytes(const void *p, size_t n) {
+  return {(const char *)p, n};
+}
+
+static std::string lock_path() { return lb_bin_path() + ".lock"; }
+
+bool lb_store_migrate() {
+  std::error_code ec;
+  if (std::filesystem::exists(lb_bin_path(), ec) ||
+      !std::filesystem::exists(lb_path(), ec))
+    return true;
+  FileLock lock(lock_path());
+  if (!lock.held())
+    return false;
+  if (std::filesystem::exists(lb_bin_path(), ec))
+    return true;
+  MappedFile f;
+  if (!f.open(lb_path()))
+    return false;
+  std::vector<LBRecord> recs;
+  std::string_view data = f.view();
+  LBEntry e{};
+  while (!data.empty()) {
+    size_t nl = data.find('\n');
+    std::string_view line = data.substr(0, nl);
+    data.remove_prefix(nl == std::string_view::npos ? data.size() : nl + 1);
+    if (parse_lb_line(line, e))
+      recs.push_back(lb_to_record(e));
+  }
+  LBFileHeader h = file_header();
+  return replace_file(lb_bin_path(),
+                      {bytes(&h, sizeof(h)),
+                       bytes(recs.data(), recs.size() * sizeof(LBRecord))});
+}
+
+// Appends are serialised on leaderboard.bin.lock so the header is written
+// exactly once and records never interleave; the fsync happens after the
+// lock is released so concurrent writers can share the disk flush. A record
+// torn by a full disk or a killed writer is cut off first, or every record
+// after it would be read misaligned.
+bool lb_store_append(const LBEntry &e) {
+  lb_store_migrate();
+  int fd = ::open(lb_bin_path().c_str(),
+                  O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return false;
+  bool ok;
+  {
+    FileLock lock(lock_path());
+    ok = lock.held();
+    struct stat st;
+    ok = ok && fstat(fd, &st) == 0;
+    off_t size = ok ? st.st_size : 0, head = sizeof(LBFileHeader);
+    off_t whole =
+        size < head ? 0 : size - (size - head) % (off_t)sizeof(LBRecord);
+    if (ok && whole != size)
+      ok = ftruncate(fd, whole) == 0;
+    if (ok && whole == 0) {
+      LBFileHeader h = file_header();
+      ok = write_all(fd, &h, sizeof(h));
+    }
+    LBRecord r = lb_to_record(e);
+    ok = ok && write_all(fd, &r, sizeof(r));
+  }
+  ok = ok && fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+}
+
+static bool reindex(const LBStoreView &s) {
+  std::vector<uint32_t> order(s.count);
+  for (uint64_t i = 0; i < s.count; i++)
+    order[i] = (uint32_t)i;
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return record_before(s.recs[a], s.recs[b]);
+  });
+  LBIndexHeader h;
+  std::memcpy(h.magic, "SNLX", 4);
+  h.version = kStoreVersion;
+  h.store_id = s.id;
+  h.reserved = 0;
+  h.covered = s.count;
+  return replace_file(lb_idx_path(),
+                      {bytes(&h, sizeof(h)),
+                       bytes(order.data(), order.size() * sizeof(uint32_t))});
+}
+
+bool lb_store_reindex() {
+  lb_store_migrate();
+  LBStoreView s;
+  return s.open() && reindex(s);
+}
+
+std::vector<LBEntry> lb_store_top(size_t k) {
+  std::vector<LBEntry> out;
+  lb_store_migrate();
+  LBStoreView s;
+  if (k == 0 || !s.open() || s.count == 0)
+    return out;
+
+  MappedFile idx;
+  const uint32_t *order = nullptr;
+  uint64_t covered = 0;
+  if (idx.open(lb_idx_path()) && idx.size >= sizeof(LBIndexHeader)) {
+    LBIndexHeader h;
+    std::memcpy(&h, idx.data, sizeof(h));
+    if (std::memcmp(h.magic, "SNLX", 4) == 0 && h.version == kStoreVersion &&
+        h.store_id == s.id && h.covered <= s.count &&
+        idx.size == sizeof(h) + h.covered * sizeof(uint32_t)) {
+      order = (const uint32_t *)(idx.data + sizeof(h));
+      covered = h.covered;
+    }
+  }
+  if (s.count - covered > kMaxUnindexed && reindex(s))
+    return lb_store_top(k);
+
+  // Best indexed rows first, then every unindexed tail record, keeping the
+  // top k in a heap whose front is the worst kept row.
+  std::vector<const LBRecord *> heap;
+  auto worse = [](const LBRecord *a, const LBRecord *b) {
+    return record_before(*a, *b);
+  };
+  auto offer = [&](const LBRecord *r) {
+    if (heap.size() < k) {
+      heap.push_back(r);
+      std::push_heap(heap.begin(), heap.end(), worse);
+    } else if (record_before(*r, *heap.front())) {
+      std::pop_heap(heap.begin(), heap.end(), worse);
+      heap.back() = r;
+      std::push_heap(heap.begin(), heap.end(), worse);
+    }
+  };
+  for (uint64_t i = 0; i < covered && i < k; i++)
+    offer(&s.recs[order[i]]);
+  for (uint64_t i = covered; i < s.count; i++)
+    offer(&s.recs[i]);
+  std::sort_heap(heap.begin(), heap.end(), worse);
+  out.reserve(heap.size());
+  for (auto *r : heap)
+    out.push_back(lb_from_record(*r));
+  return out;
+}
+
+bool lb_store_for_each(
+    const std::function<void(const LBRecord &r, uint64_t rank, uint64_t total)>
+        &fn) {
+  lb_store_migrate();
+  LBStoreView s;
+  if (!s.open())
+    return false;
+  MappedFile idx;
+  const uint32_t *order = nullptr;
+  for (int attempt = 0; attempt < 2 && !order; attempt++) {
+    if (idx.open(lb_idx_path()) && idx.size >= sizeof(LBIndexHeader)) {
+      LBIndexHeader h;
+      std::memcpy(&h, idx.data, sizeof(h));
+      if (std::memcmp(h.magic, "SNLX", 4) == 0 &&
+          h.version == kStoreVersion && h.store_id == s.id &&
+          h.covered == s.count &&
+          idx.size == sizeof(h) + h.covered * sizeof(uint32_t))
+        order = (const uint32_t *)(idx.data + sizeof(h));
+    }
+    if (!order && !reindex(s))
+      return false;
+  }
+  if (!order && s.count > 0)
+    return false;
+  for (uint64_t i = 0; i < s.count; i++)
+    fn(s.recs[order[i]], i, s.count);
+  return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "leaderboard.h"
+#include "mapped_file.h"
+#include <functional>
+
+// leaderboard.bin: an LBFileHeader followed by fixed-size LBRecords in
+// append order. leaderboard.idx: an LBIndexHeader followed by record numbers
+// sorted best-first for the first `covered` records; records appended since
+// are merged in at read time until the index is rebuilt. store_id ties an
+// index to the data file it was built from.
+struct LBFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t store_id;
+};
+
+struct LBRecord {
+  int32_t score;
+  int32_t profile;
+  uint32_t seed;
+  int32_t cols, rows;
+  int32_t wrap;
+  int32_t speed;
+  int32_t preset;
+  uint64_t ts;
+  char name[32];
+};
+
+struct LBIndexHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t store_id;
+  uint32_t reserved;
+  uint64_t covered;
+};
+
+static_assert(sizeof(LBFileHeader) == 16);
+static_assert(sizeof(LBRecord) == 72);
+static_assert(sizeof(LBIndexHeader) == 24);
+
+// leaderboard.bin mapped read-only with its header checked. A missing or
+// empty store opens with count == 0.
+struct LBStoreView {
+  MappedFile file;
+  const LBRecord *recs;
+  uint64_t count;
+  uint32_t id;
+
+  bool open();
+};
+
+LBRecord lb_to_record(const LBEntry &e);
+LBEntry lb_from_record(const LBRecord &r);
+
+bool lb_store_append(const LBEntry &e);
+std::vector<LBEntry> lb_store_top(size_t k);
+bool lb_store_reindex();
+bool lb_store_migrate();
+// Calls fn for every stored record best-first (rank 0 is the top score),
+// bringing the index up to date first.
+bool lb_store_for_each(
+    const std::function<void(const LBRecord &r, uint64_t rank, uint64_t total)>
+        &fn);
@@ -0,0 +1,103 @@
+#include "lb_store.h"
+#include "pool.h"
+#include "verify.h"
+#include <unordered_map>
+
+// Re-simulates leaderboard entries from their replays and reports the ones
+// that do not hold up. Reads leaderboard.bin (default) or a leaderboard.csv
+// of submissions given on the command line; replays are looked up by their
+// <ts>-<seed> key in the data directory's replays/ or --replays=DIR. When
+// several files share a key, the entry holds if any of them backs it.
+struct Check {
+  LBEntry e;
+  VerifyResult result;
+  int score;
+};
+
+int main(int argc, char **argv) {
+  int threads = 0, max_steps = 10000000;
+  if (!argval(argc, argv, "threads").empty())
+    parse_int(argval(argc, argv, "threads"), threads);
+  if (!argval(argc, argv, "max-steps").empty())
+    parse_int(argval(argc, argv, "max-steps"), max_steps);
+  bool all = hasflag(argc, argv, "all");
+  std::string dir = argval(argc, argv, "replays");
+  if (dir.empty())
+    dir = replay_dir();
+  std::string csv;
+  for (int i = 1; i < argc; i++)
+    if (argv[i][0] != '-')
+      csv = argv[i];
+
+  std::vector<Check> checks;
+  if (!csv.empty()) {
+    std::ifstream f(csv);
+    if (!f) {
+      fprintf(stderr, "snake_lb_verify: cannot open %s\n", csv.c_str());
+      return 1;
+    }
+    std::string line;
+    Check c{};
+    while (std::getline(f, line))
+      if (parse_lb_line(line, c.e))
+        checks.push_back(c);
+  } else {
+    bool ok = lb_store_for_each([&](const LBRecord &r, uint64_t, uint64_t) {
+      checks.push_back({lb_from_record(r), VERIFY_OK, 0});
+    });
+    if (!ok) {
+      fprintf(stderr, "snake_lb_verify: cannot read %s\n",
+              lb_bin_path().c_str());
+      return 1;
+    }
+  }
+
+  std::unordered_map<std::string, std::vector<std::string>> files;
+  std::error_code ec;
+  for (auto &de : std::filesystem::directory_iterator(dir, ec))
+    if (de.path().extension() == ".snrp")
+      files[replay_key_of(de.path().string())].push_back(de.path().string());
+  for (auto &[k, v] : files)
+    std::sort(v.begin(), v.end());
+
+  parallel_for(checks.size(), (unsigned)std::max(0, threads), [&](size_t i) {
+    Check &c = checks[i];
+    c.result = VERIFY_NO_REPLAY;
+    c.score = -1;
+    auto it = files.find(replay_key(c.e.ts, c.e.seed));
+    if (it == files.end())
+      return;
+    // The first candidate's failure is reported if none of them holds up.
+    bool first = true;
+    for (const std::string &p : it->second) {
+      Replay r;
+      int score = -1;
+      VerifyResult v = VERIFY_BAD_REPLAY;
+      if (load_replay(p, r))
+        v = verify_entry(c.e, r, (uint64_t)max_steps, score);
+      if (first || v == VERIFY_OK) {
+        c.result = v;
+        c.score = score;
+      }
+      first = false;
+      if (v == VERIFY_OK)
+        break;
+    }
+  });
+
+  uint64_t counts[VERIFY_SCORE + 1] = {};
+  printf("ts,seed,name,score,replay_score,result\n");
+  for (auto &c : checks) {
+    counts[c.result]++;
+    if (all || c.result != VERIFY_OK)
+      printf("%llu,%u,%s,%d,%d,%s\n", (unsigned long long)c.e.ts, c.e.seed,
+             c.e.name.c_str(), c.e.score, c.score, verify_name(c.result));
+  }
+  fprintf(stderr, "%zu entries:", checks.size());
+  for (int v = VERIFY_OK; v <= VERIFY_SCORE; v++)
+    if (counts[v])
+      fprintf(stderr, " %s %llu", verify_name((VerifyResult)v),
+              (unsigned long long)counts[v]);
+  fprintf(stderr, "\n");
+  return counts[VERIFY_OK] == checks.size() ? 0 : 3;
+}
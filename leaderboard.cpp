@@ -1,123 +1,97 @@
 #include "leaderboard.h"
+#include "lb_store.h"
+#include <charconv>
 
-void append_lb(const LBEntry &e) {
-  std::ofstream f(lb_path(), std::ios::app);
-  if (!f)
-    return;
-  f << e.score << "," << e.profile << "," << e.seed << "," << e.cols << ","
-    << e.rows << "," << e.wrap << "," << e.speed << "," << e.preset << ","
-    << e.name << "," << e.ts << "\n";
+bool lb_before(const LBEntry &a, const LBEntry &b) {
+  if (a.score != b.score)
+    return a.score > b.score;
+  return a.ts < b.ts;
 }
 
-std::vector<LBEntry> load_lb() {
-  std::vector<LBEntry> v;
-  std::ifstream f(lb_path());
-  if (!f)
-    return v;
-  std::string line;
-  while (std::getline(f, line)) {
-    std::stringstream ss(line);
-    std::string t;
-    LBEntry e{};
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.score = std::stoi(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.profile = std::stoi(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.seed = (uint32_t)std::stoul(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.cols = std::stoi(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.rows = std::stoi(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.wrap = std::stoi(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.speed = std::stoi(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.preset = std::stoi(t);
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.name = t;
-    if (!std::getline(ss, t, ','))
-      continue;
-    e.ts = (uint64_t)std::stoull(t);
-    v.push_back(e);
-  }
-  std::sort(v.begin(), v.end(), [](const LBEntry &a, const LBEntry &b) {
-    if (a.score != b.score)
-      return a.score > b.score;
-    return a.ts < b.ts;
-  });
-  if (v.size() > 2000)
-    v.resize(2000);
-  return v;
+void append_lb(const LBEntry &e) { lb_store_append(e); }
+
+template <class T> static bool field(std::string_view &rest, T &out) {
+  size_t comma = rest.find(',');
+  std::string_view t = rest.substr(0, comma);
+  auto r = std::from_chars(t.data(), t.data() + t.size(), out);
+  if (r.ec != std::errc() || r.ptr != t.data() + t.size() ||
+      comma == std::string_view::npos)
+    return false;
+  rest.remove_prefix(comma + 1);
+  return true;
 }
 
-bool export_html(const std::vector<LBEntry> &lb) {
-  std::ofstream f(lb_html_path(), std::ios::trunc);
-  if (!f)
+bool parse_lb_fields(std::string_view line, LBEntry &e,
+                     std::string_view &name) {
+  if (!line.empty() && line.back() == '\r')
+    line.remove_suffix(1);
+  if (!field(line, e.score) || !field(line, e.profile) ||
+      !field(line, e.seed) || !field(line, e.cols) || !field(line, e.rows) ||
+      !field(line, e.wrap) || !field(line, e.speed) || !field(line, e.preset))
     return false;
-  f << "<!doctype html><html><head><meta charset=\"utf-8\"><meta "
-       "name=\"viewport\" content=\"width=device-width,initial-scale=1\">"
-    << "<title>Snake SDL2 Leaderboard</title>"
-    << "<style>body{font-family:system-ui,-apple-system,Segoe "
-       "UI,Roboto,Ubuntu,Cantarell,Noto "
-       "Sans,sans-serif;background:#0f1115;color:#e6e6e6;margin:24px}"
-    << "h1{font-size:20px;margin:0 0 "
-       "16px}table{width:100%;border-collapse:collapse;border:1px solid "
-       "#2b2f3a;border-radius:8px;overflow:hidden}"
-    << "th,td{padding:10px 12px;border-bottom:1px solid "
-       "#2b2f3a;font-size:14px;text-align:left}th{background:#171a21}tr:nth-"
-       "child(even){background:#12141a}"
-    << ".sub{color:#b0b5c0;font-size:12px}code{background:#171a21;padding:2px "
-       "6px;border-radius:6px}</style></head><body>";
-  f << "<h1>Snake SDL2 Leaderboard</h1>";
-  f << "<div class=\"sub\">Rows: " << lb.size() << "</div>";
-  f << "<table><thead><tr><th>#</th><th>Name</th><th>Score</th><th>Profile</"
-       "th><th>Grid</th><th>Wrap</th><th>Speed</th><th>Preset</th><th>Seed</"
-       "th><th>Time</th></tr></thead><tbody>";
-  int rank = 1;
-  for (const auto &e : lb) {
-    f << "<tr><td>" << rank++ << "</td><td>" << e.name << "</td><td>" << e.score
-      << "</td><td>" << e.profile << "</td>"
-      << "<td>" << e.cols << "×" << e.rows << "</td><td>"
-      << (e.wrap ? "On" : "Off") << "</td><td>" << e.speed << " ms</td>"
-      << "<td>" << e.preset << "</td><td><code>" << e.seed << "</code></td><td>"
-      << e.ts << "</td></tr>";
-    if (rank > 200)
-      break;
-  }
-  f << "</tbody></table></body></html>";
-  f.flush();
-  return f.good();
+  size_t comma = line.rfind(',');
+  if (comma == std::string_view::npos)
+    return false;
+  std::string_view ts = line.substr(comma + 1);
+  auto r = std::from_chars(ts.data(), ts.data() + ts.size(), e.ts);
+  if (r.ec != std::errc() || r.ptr != ts.data() + ts.size())
+    return false;
+  name = line.substr(0, comma);
+  return true;
 }
 
-bool export_json(const std::vector<LBEntry> &lb) {
-  std::ofstream f(lb_json_path(), std::ios::trunc);
-  if (!f)
+bool parse_lb_line(std::string_view line, LBEntry &e) {
+  std::string_view name;
+  if (!parse_lb_fields(line, e, name))
     return false;
-  f << "{\n  \"entries\": [\n";
-  for (size_t i = 0; i < lb.size() && i < 1000; i++) {
-    const auto &e = lb[i];
-    f << "    {\"rank\": " << (int)(i + 1) << ", \"name\": \"" << e.name
-      << "\", \"score\": " << e.score << ", \"profile\": " << e.profile
-      << ", \"seed\": " << e.seed << ", \"cols\": " << e.cols
-      << ", \"rows\": " << e.rows << ", \"wrap\": " << (e.wrap ? true : false)
-      << ", \"speed_ms\": " << e.speed << ", \"preset\": " << e.preset
-      << ", \"timestamp\": " << e.ts << "}";
-    if (i + 1 < lb.size() && i + 1 < 1000)
-      f << ",";
-    f << "\n";
+  e.name.assign(name);
+  return true;
+}
+
+std::vector<LBEntry> load_lb(size_t k) { return lb_store_top(k); }
+
+Leaderboard::Leaderboard() {
+  keep = 2000;
+  size = 0;
+  loaded = false;
+}
+
+bool Leaderboard::stale() const {
+  std::error_code ec;
+  auto t = std::filesystem::last_write_time(lb_bin_path(), ec);
+  if (ec)
+    return size != 0;
+  uintmax_t n = std::filesystem::file_size(lb_bin_path(), ec);
+  return ec || t != mtime || n != size;
+}
+
+void Leaderboard::stamp() {
+  std::error_code ec;
+  mtime = std::filesystem::last_write_time(lb_bin_path(), ec);
+  size = ec ? 0 : std::filesystem::file_size(lb_bin_path(), ec);
+  if (ec)
+    size = 0;
+}
+
+const std::vector<LBEntry> &Leaderboard::get() {
+  if (!loaded || stale()) {
+    entries = load_lb(keep);
+    stamp();
+    loaded = true;
+  }
+  return entries;
+}
+
+void Leaderboard::append(const LBEntry &e) {
+  bool current = loaded && !stale();
+  append_lb(e);
+  if (!current) {
+    loaded = false;
+    return;
   }
-  f << "  ]\n}\n";
-  f.flush();
-  return f.good();
+  entries.insert(std::upper_bound(entries.begin(), entries.end(), e, lb_before),
+                 e);
+  if (entries.size() > keep)
+    entries.resize(keep);
+  stamp();
 }
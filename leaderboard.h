@@ -1,6 +1,7 @@
 #pragma once
 #include "common.h"
 #include "config.h"
+#include <string_view>
 
 struct LBEntry {
   int score;
@@ -14,7 +15,26 @@ struct LBEntry {
   uint64_t ts;
 };
 
+// Top `keep` leaderboard rows kept in memory. They are loaded on first use
+// and reloaded only when leaderboard.bin changes on disk; our own appends are
+// merged in place.
+struct Leaderboard {
+  std::vector<LBEntry> entries;
+  size_t keep;
+  std::filesystem::file_time_type mtime;
+  uintmax_t size;
+  bool loaded;
+
+  Leaderboard();
+  const std::vector<LBEntry> &get();
+  void append(const LBEntry &e);
+  bool stale() const;
+  void stamp();
+};
+
+bool lb_before(const LBEntry &a, const LBEntry &b);
+bool parse_lb_fields(std::string_view line, LBEntry &e,
+                     std::string_view &name);
+bool parse_lb_line(std::string_view line, LBEntry &e);
 void append_lb(const LBEntry &e);
-std::vector<LBEntry> load_lb();
-bool export_html(const std::vector<LBEntry> &lb);
-bool export_json(const std::vector<LBEntry> &lb);
+std::vector<LBEntry> load_lb(size_t k);
@@ -1,8 +1,25 @@
 #include "game.h"
 
+// --replay=FILE --headless: play the replay at full speed without opening a
+// window and check it reaches the recorded score and step count.
+static int run_headless(const Game &g) {
+  Sim s;
+  if (!run_replay(g.replay, s))
+    return 1;
+  bool ok = s.score == g.replay.score && s.steps == g.replay.steps;
+  printf("challenge,score,steps,recorded_score,recorded_steps,result\n");
+  printf("%s,%d,%llu,%d,%llu,%s\n", g.replay.challenge.c_str(), s.score,
+         (unsigned long long)s.steps, g.replay.score,
+         (unsigned long long)g.replay.steps, ok ? "ok" : "mismatch");
+  return ok ? 0 : 3;
+}
+
 int main(int argc, char **argv) {
   Game g;
-  g.init_from_args(argc, argv);
+  if (!g.init_from_args(argc, argv))
+    return 1;
+  if (g.playback && hasflag(argc, argv, "headless"))
+    return run_headless(g);
   if (!g.init_sdl())
     return 1;
   g.loop();
@@ -0,0 +1,43 @@
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile() {
+  data = nullptr;
+  size = 0;
+}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size > 0) {
+    void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    data = (const char *)p;
+    size = (size_t)st.st_size;
+  }
+  ::close(fd);
+  return true;
+}
+
+void MappedFile::close() {
+  if (data)
+    munmap((void *)data, size);
+  data = nullptr;
+  size = 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "common.h"
+#include <string_view>
+
+// Read-only memory map of a whole file. An empty or missing file maps to an
+// empty view.
+struct MappedFile {
+  const char *data;
+  size_t size;
+
+  MappedFile();
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  bool open(const std::string &path);
+  void close();
+  std::string_view view() const { return {data, size}; }
+};
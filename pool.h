@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs fn(i) for every i in [0, n) on `threads` workers. Each worker starts
+// with an even slice of the index space; a worker that runs dry steals the
+// upper half of another worker's remaining slice.
+template <class F> void parallel_for(size_t n, unsigned threads, F &&fn) {
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  if (n < threads)
+    threads = (unsigned)std::max<size_t>(1, n);
+  struct Slice {
+    std::mutex m;
+    size_t lo, hi;
+  };
+  std::vector<Slice> q(threads);
+  for (unsigned w = 0; w < threads; w++) {
+    q[w].lo = n * w / threads;
+    q[w].hi = n * (w + 1) / threads;
+  }
+  auto take = [&](unsigned w, size_t &i) {
+    {
+      std::lock_guard<std::mutex> g(q[w].m);
+      if (q[w].lo < q[w].hi) {
+        i = q[w].lo++;
+        return true;
+      }
+    }
+    for (unsigned k = 1; k < threads; k++) {
+      Slice &v = q[(w + k) % threads];
+      size_t mid, hi;
+      {
+        std::lock_guard<std::mutex> g(v.m);
+        if (v.lo >= v.hi)
+          continue;
+        hi = v.hi;
+        mid = v.lo + (v.hi - v.lo) / 2;
+        v.hi = mid;
+      }
+      std::lock_guard<std::mutex> g(q[w].m);
+      q[w].lo = mid + 1;
+      q[w].hi = hi;
+      i = mid;
+      return true;
+    }
+    return false;
+  };
+  auto work = [&](unsigned w) {
+    size_t i;
+    while (take(w, i))
+      fn(i);
+  };
+  std::vector<std::thread> pool;
+  for (unsigned w = 1; w < threads; w++)
+    pool.emplace_back(work, w);
+  work(0);
+  for (auto &t : pool)
+    t.join();
+}
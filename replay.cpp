@@ -0,0 +1,143 @@
+#include "replay.h"
+#include "challenge.h"
+#include "fileio.h"
+
+static const char kReplayMagic[4] = {'S', 'N', 'R', 'P'};
+
+Replay::Replay() {
+  rules = kSimRules;
+  steps = 0;
+  score = 0;
+}
+
+void Replay::begin(const std::string &ch) {
+  rules = kSimRules;
+  challenge = ch;
+  turns.clear();
+  steps = 0;
+  score = 0;
+}
+
+void Replay::turn(uint64_t step, Dir d) { turns.push_back({step, d}); }
+
+static void put_varint(std::string &out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back((char)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((char)v);
+}
+
+static bool get_varint(std::string_view s, size_t &pos, uint64_t &v) {
+  v = 0;
+  for (int shift = 0; shift < 64 && pos < s.size(); shift += 7) {
+    unsigned char b = (unsigned char)s[pos++];
+    v |= (uint64_t)(b & 0x7f) << shift;
+    if (!(b & 0x80))
+      return true;
+  }
+  return false;
+}
+
+std::string encode_replay(const Replay &r) {
+  std::string out(kReplayMagic, sizeof kReplayMagic);
+  put_varint(out, r.rules);
+  put_varint(out, r.challenge.size());
+  out += r.challenge;
+  put_varint(out, r.steps);
+  put_varint(out, (uint64_t)r.score);
+  put_varint(out, r.turns.size());
+  uint64_t prev = 0;
+  for (auto &t : r.turns) {
+    put_varint(out, (t.step - prev) << 2 | (uint64_t)t.dir);
+    prev = t.step;
+  }
+  return out;
+}
+
+bool decode_replay(std::string_view s, Replay &r) {
+  if (s.size() < sizeof kReplayMagic ||
+      s.substr(0, sizeof kReplayMagic) !=
+          std::string_view(kReplayMagic, sizeof kReplayMagic))
+    return false;
+  size_t pos = sizeof kReplayMagic;
+  uint64_t rules, len, steps, score, n;
+  if (!get_varint(s, pos, rules) || !get_varint(s, pos, len) ||
+      len > s.size() - pos)
+    return false;
+  r.rules = (uint32_t)rules;
+  r.challenge = std::string(s.substr(pos, len));
+  pos += len;
+  if (!get_varint(s, pos, steps) || !get_varint(s, pos, score) ||
+      !get_varint(s, pos, n) || n > s.size() - pos)
+    return false;
+  r.steps = steps;
+  r.score = (int)score;
+  r.turns.clear();
+  r.turns.reserve(n);
+  uint64_t step = 0;
+  for (uint64_t i = 0; i < n; i++) {
+    uint64_t v;
+    if (!get_varint(s, pos, v))
+      return false;
+    step += v >> 2;
+    r.turns.push_back({step, (Dir)(v & 3)});
+  }
+  return pos == s.size();
+}
+
+bool save_replay(const std::string &path, const Replay &r) {
+  std::string data = encode_replay(r);
+  return replace_file(path, {data});
+}
+
+bool load_replay(const std::string &path, Replay &r) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f)
+    return false;
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return decode_replay(ss.str(), r);
+}
+
+ReplayPlayer::ReplayPlayer() {
+  replay = nullptr;
+  next = 0;
+}
+
+bool ReplayPlayer::start(const Replay &r, Sim &s) {
+  uint32_t seed;
+  int cols, rows, speed, preset;
+  bool wrap;
+  if (r.rules != kSimRules ||
+      !parse_challenge(r.challenge, seed, cols, rows, wrap, speed, preset) ||
+      cols < kMinBoard || cols > kMaxBoard || rows < kMinBoard ||
+      rows > kMaxBoard)
+    return false;
+  replay = &r;
+  next = 0;
+  s.reset(seed, cols, rows, wrap, std::clamp(speed, kMinSpeed, kMaxSpeed));
+  return true;
+}
+
+Dir ReplayPlayer::dir(const Sim &s) {
+  const std::vector<ReplayTurn> &t = replay->turns;
+  while (next < t.size() && t[next].step < s.steps)
+    next++;
+  if (next < t.size() && t[next].step == s.steps)
+    return t[next++].dir;
+  return s.dir;
+}
+
+bool ReplayPlayer::done(const Sim &s) const {
+  return s.over || s.steps >= replay->steps;
+}
+
+bool run_replay(const Replay &r, Sim &s) {
+  ReplayPlayer p;
+  if (!p.start(r, s))
+    return false;
+  while (!p.done(s))
+    s.step(p.dir(s));
+  return true;
+}
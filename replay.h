@@ -0,0 +1,45 @@
+#pragma once
+#include "common.h"
+#include "sim.h"
+#include <string_view>
+
+struct ReplayTurn {
+  uint64_t step;
+  Dir dir;
+};
+
+// One game: the challenge it was played on, the sim rules version, every
+// direction change keyed by the step it was applied on, and how the game
+// ended. Encoded as "SNRP" followed by varints; each turn is one varint of
+// (step delta << 2 | dir), so a typical game takes a few bytes per turn.
+struct Replay {
+  uint32_t rules;
+  std::string challenge;
+  std::vector<ReplayTurn> turns;
+  uint64_t steps;
+  int score;
+
+  Replay();
+  void begin(const std::string &ch);
+  void turn(uint64_t step, Dir d);
+};
+
+std::string encode_replay(const Replay &r);
+bool decode_replay(std::string_view s, Replay &r);
+bool save_replay(const std::string &path, const Replay &r);
+bool load_replay(const std::string &path, Replay &r);
+
+// Feeds a replay's turns into a Sim step by step.
+struct ReplayPlayer {
+  const Replay *replay;
+  size_t next;
+
+  ReplayPlayer();
+  bool start(const Replay &r, Sim &s);
+  Dir dir(const Sim &s);
+  bool done(const Sim &s) const;
+};
+
+// Plays r to the end as fast as possible. False if the challenge cannot be
+// parsed or the replay was recorded under different sim rules.
+bool run_replay(const Replay &r, Sim &s);
@@ -0,0 +1,101 @@
+#include "sim.h"
+
+const uint32_t kSimRules = 2;
+
+static void reset_snake(SnakeBody &s, int cols, int rows) {
+  s.clear();
+  s.push_front({cols / 2 - 2, rows / 2});
+  s.push_front({cols / 2 - 1, rows / 2});
+  s.push_front({cols / 2, rows / 2});
+}
+
+Sim::Sim() {
+  seed = 0;
+  cols = 32;
+  rows = 24;
+  wrap = false;
+  speed = 120;
+  tick_ms = 120;
+  dir = R;
+  score = 0;
+  level = 1;
+  steps = 0;
+  over = false;
+  food = {-1, -1};
+}
+
+void Sim::reset(uint32_t sd, int c, int r, bool w, int sp) {
+  rng.seed(sd);
+  seed = sd;
+  cols = c;
+  rows = r;
+  wrap = w;
+  speed = sp;
+  tick_ms = sp;
+  reset_snake(snake, cols, rows);
+  dir = R;
+  score = 0;
+  level = 1;
+  steps = 0;
+  over = false;
+  walls = wall_table(cols, rows);
+  board.reset(cols, rows);
+  board.add_walls(walls->level(level));
+  for (size_t i = 0; i < snake.size(); i++)
+    board.add_body(snake[i]);
+  spawn_food();
+}
+
+void Sim::spawn_food() {
+  if (!board.random_free(rng, food))
+    food = {-1, -1};
+}
+
+StepResult Sim::step(Dir d) {
+  if (over)
+    return STEP_DIED;
+  if (!opposite(d, dir))
+    dir = d;
+  P head = snake.front();
+  if (dir == U)
+    head.y--;
+  else if (dir == D)
+    head.y++;
+  else if (dir == L)
+    head.x--;
+  else if (dir == R)
+    head.x++;
+  if (wrap) {
+    if (head.x < 0)
+      head.x = cols - 1;
+    if (head.x >= cols)
+      head.x = 0;
+    if (head.y < 0)
+      head.y = rows - 1;
+    if (head.y >= rows)
+      head.y = 0;
+  }
+  steps++;
+  if (!board.inside(head) || board.blocked(head)) {
+    over = true;
+    return STEP_DIED;
+  }
+  bool ate = (head.x == food.x && head.y == food.y);
+  snake.push_front(head);
+  board.add_body(head);
+  if (!ate) {
+    board.remove_body(snake.back());
+    snake.pop_back();
+    return STEP_MOVED;
+  }
+  score++;
+  if (tick_ms > 30)
+    tick_ms -= 3;
+  int lvl = std::min(kMaxLevel, 1 + score / 5);
+  if (lvl != level) {
+    board.add_walls(walls->added(level, lvl));
+    level = lvl;
+  }
+  spawn_food();
+  return STEP_ATE;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "board.h"
+#include "common.h"
+#include "snake_body.h"
+#include "walls.h"
+
+enum StepResult { STEP_MOVED, STEP_ATE, STEP_DIED };
+
+// Bumped whenever a change to Sim makes the same inputs play out
+// differently, so old replays are rejected instead of mis-verified.
+extern const uint32_t kSimRules;
+
+// Board size and tick (ms) limits for command line, challenge and replay
+// input.
+const int kMinBoard = 8;
+const int kMaxBoard = 4096;
+const int kMinSpeed = 30;
+const int kMaxSpeed = 400;
+
+struct Sim {
+  std::mt19937 rng;
+  uint32_t seed;
+  int cols, rows;
+  bool wrap;
+  int speed, tick_ms;
+  SnakeBody snake;
+  Dir dir;
+  int score, level;
+  uint64_t steps;
+  bool over;
+  std::shared_ptr<const WallTable> walls;
+  Board board;
+  P food;
+
+  Sim();
+  void reset(uint32_t seed, int cols, int rows, bool wrap, int speed = 120);
+  StepResult step(Dir d);
+  void spawn_food();
+};
@@ -0,0 +1,25 @@
+#include "snake_body.h"
+
+SnakeBody::SnakeBody() {
+  head = 0;
+  len = 0;
+}
+
+void SnakeBody::clear() {
+  head = 0;
+  len = 0;
+}
+
+void SnakeBody::push_front(P p) {
+  // Keep room for the new head plus the slot behind the tail.
+  if (len + 2 > ring.size()) {
+    std::vector<P> bigger(std::max<size_t>(16, ring.size() * 2));
+    size_t mask = bigger.size() - 1;
+    for (uint64_t s = head - len; s != head + 1 && !ring.empty(); s++)
+      bigger[s & mask] = at(s);
+    ring.swap(bigger);
+  }
+  head++;
+  ring[head & (ring.size() - 1)] = p;
+  len++;
+}
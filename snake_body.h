@@ -0,0 +1,33 @@
+#pragma once
+#include "common.h"
+
+// The snake's cells in a power-of-two ring, addressed by sequence number:
+// the head is `head`, segment i behind it is head - i and the tail is
+// head - len + 1. A step writes one slot and moves the counters, so its cost
+// does not depend on the length. The ring keeps one slot beyond the tail,
+// which still holds where the tail was before the last move.
+struct SnakeBody {
+  std::vector<P> ring;
+  uint64_t head;
+  size_t len;
+
+  SnakeBody();
+  void clear();
+  size_t size() const { return len; }
+  bool empty() const { return len == 0; }
+  uint64_t tail() const { return head - len + 1; }
+  const P &at(uint64_t seq) const { return ring[seq & (ring.size() - 1)]; }
+  const P &operator[](size_t i) const { return at(head - i); }
+  const P &front() const { return at(head); }
+  const P &back() const { return at(tail()); }
+  void push_front(P p);
+  void pop_back() { len--; }
+};
+
+// Head and length at some earlier tick. Segment i was then at
+// body.at(head - i) for i < len, as long as the body has moved at most one
+// step since.
+struct BodySnap {
+  uint64_t head;
+  size_t len;
+};
@@ -0,0 +1,231 @@
+#include "text.h"
+
+static const size_t kMaxRuns = 512;
+static const int kAtlasW = 512, kAtlasH = 512;
+
+static uint32_t next_cp(const std::string &s, size_t &i) {
+  unsigned char c = s[i++];
+  int extra = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+  uint32_t cp = extra == 3 ? c & 0x07 : extra == 2 ? c & 0x0f : c & 0x3f;
+  if (extra == 0)
+    return c;
+  while (extra-- > 0 && i < s.size())
+    cp = (cp << 6) | (s[i++] & 0x3f);
+  return cp;
+}
+
+static std::string utf8(uint32_t cp) {
+  std::string s;
+  if (cp < 0x80)
+    s += (char)cp;
+  else if (cp < 0x800) {
+    s += (char)(0xc0 | (cp >> 6));
+    s += (char)(0x80 | (cp & 0x3f));
+  } else {
+    s += (char)(0xe0 | (cp >> 12));
+    s += (char)(0x80 | ((cp >> 6) & 0x3f));
+    s += (char)(0x80 | (cp & 0x3f));
+  }
+  return s;
+}
+
+TextRenderer::TextRenderer() {
+  ren = nullptr;
+  font = nullptr;
+  atlas = nullptr;
+  atlas_w = 0;
+  atlas_h = 0;
+  pack_x = pack_y = row_h = 0;
+  frame = 0;
+}
+
+// Renders cp in white and fills in its metrics (not its place).
+SDL_Surface *TextRenderer::render(uint32_t cp, Glyph &g) {
+  if (cp > 0xffff || (cp > 0x7f && !TTF_GlyphIsProvided(font, (Uint16)cp)))
+    return nullptr;
+  SDL_Color white{255, 255, 255, 255};
+  SDL_Surface *s = TTF_RenderUTF8_Blended(font, utf8(cp).c_str(), white);
+  if (!s)
+    return nullptr;
+  int minx, maxx, miny, maxy, adv;
+  if (TTF_GlyphMetrics(font, (Uint16)cp, &minx, &maxx, &miny, &maxy, &adv) !=
+      0) {
+    SDL_FreeSurface(s);
+    return nullptr;
+  }
+  g.minx = std::min(0, minx);
+  g.advance = adv;
+  return s;
+}
+
+// Next free w x h spot in the atlas, packed in rows.
+bool TextRenderer::place(int w, int h, SDL_Rect &out) {
+  if (pack_x + w > kAtlasW) {
+    pack_x = 0;
+    pack_y += row_h + 1;
+    row_h = 0;
+  }
+  if (w > kAtlasW || pack_y + h > kAtlasH)
+    return false;
+  out = {pack_x, pack_y, w, h};
+  pack_x += w + 1;
+  row_h = std::max(row_h, h);
+  return true;
+}
+
+// The atlas glyph for cp, adding it on first use. Characters the font lacks
+// or that no longer fit show as '?'.
+const TextRenderer::Glyph *TextRenderer::glyph(uint32_t cp) {
+  auto it = glyphs.find(cp);
+  if (it != glyphs.end())
+    return &it->second;
+  Glyph g;
+  SDL_Surface *s = render(cp, g);
+  bool ok = false;
+  if (s && place(s->w, s->h, g.src)) {
+    Uint32 fmt;
+    SDL_Surface *cv = nullptr;
+    if (SDL_QueryTexture(atlas, &fmt, nullptr, nullptr, nullptr) == 0)
+      cv = SDL_ConvertSurfaceFormat(s, fmt, 0);
+    ok = cv && SDL_UpdateTexture(atlas, &g.src, cv->pixels, cv->pitch) == 0;
+    if (cv)
+      SDL_FreeSurface(cv);
+  }
+  if (s)
+    SDL_FreeSurface(s);
+  if (!ok) {
+    auto q = glyphs.find('?');
+    if (q == glyphs.end())
+      return nullptr;
+    g = q->second;
+  }
+  return &(glyphs[cp] = g);
+}
+
+bool TextRenderer::init(SDL_Renderer *r, TTF_Font *f) {
+  ren = r;
+  font = f;
+  if (!font)
+    return false;
+  std::vector<uint32_t> cps;
+  for (uint32_t c = 32; c < 127; c++)
+    cps.push_back(c);
+  cps.push_back(0x00d7); // ×
+  cps.push_back(0x2022); // •
+
+  std::vector<std::pair<uint32_t, SDL_Surface *>> surfs;
+  pack_x = pack_y = row_h = 0;
+  for (uint32_t cp : cps) {
+    Glyph g;
+    SDL_Surface *s = render(cp, g);
+    if (!s)
+      continue;
+    if (!place(s->w, s->h, g.src)) {
+      SDL_FreeSurface(s);
+      continue;
+    }
+    glyphs[cp] = g;
+    surfs.push_back({cp, s});
+  }
+  // The atlas keeps its full size from the start so the texture coordinates
+  // of laid out runs stay valid as glyphs are added.
+  atlas_w = kAtlasW;
+  atlas_h = kAtlasH;
+  SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(
+      0, atlas_w, atlas_h, 32, SDL_PIXELFORMAT_RGBA32);
+  if (sheet) {
+    SDL_FillRect(sheet, nullptr, 0);
+    for (auto &[cp, s] : surfs) {
+      SDL_SetSurfaceBlendMode(s, SDL_BLENDMODE_NONE);
+      SDL_Rect dst = glyphs[cp].src;
+      SDL_BlitSurface(s, nullptr, sheet, &dst);
+    }
+    atlas = SDL_CreateTextureFromSurface(ren, sheet);
+    SDL_FreeSurface(sheet);
+  }
+  for (auto &[cp, s] : surfs)
+    SDL_FreeSurface(s);
+  if (!atlas) {
+    glyphs.clear();
+    return false;
+  }
+  SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+  return true;
+}
+
+const TextRenderer::Run &TextRenderer::layout(const std::string &s,
+                                              SDL_Color c) {
+  std::string key = s;
+  key += (char)c.r;
+  key += (char)c.g;
+  key += (char)c.b;
+  key += (char)c.a;
+  auto it = runs.find(key);
+  if (it != runs.end()) {
+    it->second.last_use = frame;
+    return it->second;
+  }
+  if (runs.size() >= kMaxRuns)
+    for (auto i = runs.begin(); i != runs.end();)
+      i = i->second.last_use != frame ? runs.erase(i) : std::next(i);
+  Run &run = runs[key];
+  run.last_use = frame;
+  float iw = 1.0f / atlas_w, ih = 1.0f / atlas_h;
+  int pen = 0;
+  uint32_t prev = 0;
+  for (size_t i = 0; i < s.size();) {
+    uint32_t cp = next_cp(s, i);
+    const Glyph *g = glyph(cp);
+    if (!g)
+      continue;
+    if (prev)
+      pen += TTF_GetFontKerningSizeGlyphs(font, (Uint16)prev, (Uint16)cp);
+    prev = cp;
+    const SDL_Rect &r = g->src;
+    float x0 = (float)(pen + g->minx), x1 = x0 + r.w, y1 = (float)r.h;
+    float u0 = r.x * iw, u1 = (r.x + r.w) * iw, v0 = r.y * ih,
+          v1 = (r.y + r.h) * ih;
+    run.verts.push_back({{x0, 0}, c, {u0, v0}});
+    run.verts.push_back({{x1, 0}, c, {u1, v0}});
+    run.verts.push_back({{x1, y1}, c, {u1, v1}});
+    run.verts.push_back({{x0, y1}, c, {u0, v1}});
+    pen += g->advance;
+  }
+  return run;
+}
+
+void TextRenderer::draw(const std::string &s, int x, int y, SDL_Color c) {
+  if (!atlas)
+    return;
+  const Run &run = layout(s, c);
+  for (size_t q = 0; q < run.verts.size(); q += 4) {
+    int base = (int)verts.size();
+    for (int k = 0; k < 4; k++) {
+      SDL_Vertex v = run.verts[q + k];
+      v.position.x += x;
+      v.position.y += y;
+      verts.push_back(v);
+    }
+    for (int k : {0, 1, 2, 0, 2, 3})
+      idx.push_back(base + k);
+  }
+}
+
+void TextRenderer::flush() {
+  if (atlas && !idx.empty())
+    SDL_RenderGeometry(ren, atlas, verts.data(), (int)verts.size(),
+                       idx.data(), (int)idx.size());
+  verts.clear();
+  idx.clear();
+  frame++;
+}
+
+void TextRenderer::quit() {
+  if (atlas)
+    SDL_DestroyTexture(atlas);
+  atlas = nullptr;
+  glyphs.clear();
+  runs.clear();
+  verts.clear();
+  idx.clear();
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "common.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <unordered_map>
+
+// Text drawn from a single glyph atlas texture. Strings are laid out once
+// into quads (cached by content and colour), appended to a per-frame vertex
+// batch and submitted with one SDL_RenderGeometry call on flush(). The atlas
+// starts with ASCII and a few symbols; other characters are rendered into
+// its free space the first time they are drawn.
+struct TextRenderer {
+  struct Glyph {
+    SDL_Rect src;
+    int minx, advance;
+  };
+  struct Run {
+    std::vector<SDL_Vertex> verts;
+    uint32_t last_use;
+  };
+  SDL_Renderer *ren;
+  TTF_Font *font;
+  SDL_Texture *atlas;
+  int atlas_w, atlas_h;
+  int pack_x, pack_y, row_h;
+  std::unordered_map<uint32_t, Glyph> glyphs;
+  std::unordered_map<std::string, Run> runs;
+  std::vector<SDL_Vertex> verts;
+  std::vector<int> idx;
+  uint32_t frame;
+
+  TextRenderer();
+  bool init(SDL_Renderer *r, TTF_Font *f);
+  void draw(const std::string &s, int x, int y, SDL_Color c);
+  void flush();
+  void quit();
+
+  const Run &layout(const std::string &s, SDL_Color c);
+  SDL_Surface *render(uint32_t cp, Glyph &g);
+  bool place(int w, int h, SDL_Rect &out);
+  const Glyph *glyph(uint32_t cp);
+};
@@ -0,0 +1,54 @@
+#include "verify.h"
+#include "challenge.h"
+
+const char *verify_name(VerifyResult v) {
+  switch (v) {
+  case VERIFY_OK:
+    return "ok";
+  case VERIFY_NO_REPLAY:
+    return "no-replay";
+  case VERIFY_BAD_REPLAY:
+    return "bad-replay";
+  case VERIFY_RULES:
+    return "rules";
+  case VERIFY_CHALLENGE:
+    return "challenge";
+  case VERIFY_TOO_LONG:
+    return "too-long";
+  case VERIFY_UNFINISHED:
+    return "unfinished";
+  case VERIFY_SCORE:
+    return "score";
+  }
+  return "?";
+}
+
+VerifyResult verify_entry(const LBEntry &e, const Replay &r,
+                          uint64_t max_steps, int &score) {
+  score = -1;
+  uint32_t seed;
+  int cols, rows, speed, preset;
+  bool wrap;
+  if (r.rules != kSimRules)
+    return VERIFY_RULES;
+  // Replays are untrusted: a board outside the playable range would make
+  // the sim write out of bounds or allocate without limit.
+  if (!parse_challenge(r.challenge, seed, cols, rows, wrap, speed, preset) ||
+      cols < kMinBoard || cols > kMaxBoard || rows < kMinBoard ||
+      rows > kMaxBoard)
+    return VERIFY_BAD_REPLAY;
+  if (seed != e.seed || cols != e.cols || rows != e.rows ||
+      wrap != (e.wrap != 0) || speed != e.speed)
+    return VERIFY_CHALLENGE;
+  // The step count is checked up front so a forged replay cannot make the
+  // verifier run for an unbounded time.
+  if (r.steps > max_steps)
+    return VERIFY_TOO_LONG;
+  Sim s;
+  if (!run_replay(r, s))
+    return VERIFY_BAD_REPLAY;
+  score = s.score;
+  if (s.score != e.score)
+    return VERIFY_SCORE;
+  return s.over && s.steps == r.steps ? VERIFY_OK : VERIFY_UNFINISHED;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "leaderboard.h"
+#include "replay.h"
+
+enum VerifyResult {
+  VERIFY_OK,
+  VERIFY_NO_REPLAY,
+  VERIFY_BAD_REPLAY,
+  VERIFY_RULES,
+  VERIFY_CHALLENGE,
+  VERIFY_TOO_LONG,
+  VERIFY_UNFINISHED,
+  VERIFY_SCORE
+};
+
+const char *verify_name(VerifyResult v);
+
+// Re-simulates r and accepts e only if the replay was played on e's
+// seed/cols/rows/wrap/speed under the current sim rules, ends in death
+// within max_steps, and scores exactly e.score. `score` receives the
+// re-simulated score (-1 if the replay could not be run).
+VerifyResult verify_entry(const LBEntry &e, const Replay &r,
+                          uint64_t max_steps, int &score);
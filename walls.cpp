@@ -0,0 +1,83 @@
+#include "walls.h"
+#include <map>
+#include <mutex>
+
+WallTable::WallTable() {
+  cols = rows = 0;
+  std::fill(std::begin(end), std::end(end), 0);
+  std::fill(std::begin(layout), std::end(layout), 0);
+}
+
+static std::shared_ptr<const WallTable> build(int cols, int rows) {
+  auto t = std::make_shared<WallTable>();
+  t->cols = cols;
+  t->rows = rows;
+  // Borders share corners and later segments may cross earlier ones, so
+  // cells already placed are skipped.
+  std::vector<uint64_t> seen(((size_t)cols * rows + 63) / 64, 0);
+  auto add = [&](int x, int y) {
+    if (x < 0 || x >= cols || y < 0 || y >= rows)
+      return;
+    size_t i = (size_t)y * cols + x;
+    if ((seen[i >> 6] >> (i & 63)) & 1)
+      return;
+    seen[i >> 6] |= uint64_t(1) << (i & 63);
+    t->cells.push_back({x, y});
+  };
+  for (int lvl = 1; lvl <= kMaxLevel; lvl++) {
+    if (lvl == 1) {
+      for (int x = 0; x < cols; x++) {
+        add(x, 0);
+        add(x, rows - 1);
+      }
+      for (int y = 0; y < rows; y++) {
+        add(0, y);
+        add(cols - 1, y);
+      }
+    }
+    if (lvl == 2)
+      for (int x = 6; x < cols - 6; x++)
+        add(x, rows / 2);
+    if (lvl == 3)
+      for (int y = 4; y < rows - 4; y++)
+        add(cols / 3, y);
+    if (lvl == 4)
+      for (int y = 4; y < rows - 4; y++)
+        add(2 * cols / 3, y);
+    if (lvl == 5)
+      for (int x = 8; x < cols - 8; x++)
+        if ((x / 2) % 2 == 0) {
+          add(x, 5);
+          add(x, rows - 6);
+        }
+    if (lvl == 6)
+      for (int y = 6; y < rows - 6; y++)
+        if ((y / 2) % 2 == 0) {
+          add(5, y);
+          add(cols - 6, y);
+        }
+    t->end[lvl] = t->cells.size();
+    // Levels only add cells, so a level that added none repeats the last.
+    bool same = lvl > 1 && t->end[lvl] == t->end[lvl - 1];
+    t->layout[lvl] = same ? t->layout[lvl - 1] : lvl;
+  }
+  return t;
+}
+
+std::shared_ptr<const WallTable> wall_table(int cols, int rows) {
+  static std::mutex m;
+  static std::map<std::pair<int, int>, std::weak_ptr<const WallTable>> cache;
+  std::lock_guard<std::mutex> g(m);
+  for (auto it = cache.begin(); it != cache.end();)
+    if (it->second.expired())
+      it = cache.erase(it);
+    else
+      ++it;
+  std::weak_ptr<const WallTable> &slot = cache[{cols, rows}];
+  std::shared_ptr<const WallTable> t = slot.lock();
+  if (!t) {
+    t = build(cols, rows);
+    slot = t;
+  }
+  return t;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "common.h"
+#include <memory>
+#include <span>
+
+// Levels run from 1 to kMaxLevel; the last ones repeat the layout of 6.
+const int kMaxLevel = 8;
+
+// Wall layouts of every level for one board size. A level only adds walls
+// to the one before it, so cells holds each wall cell once, in the order the
+// levels add them, and the walls of level l are cells[0, end[l]).
+struct WallTable {
+  int cols, rows;
+  std::vector<P> cells;
+  size_t end[kMaxLevel + 1];
+  // Levels with the same layout number have identical walls; it is the
+  // lowest such level. Caches of per-layout data key on it.
+  int layout[kMaxLevel + 1];
+
+  WallTable();
+  std::span<const P> level(int l) const { return {cells.data(), end[l]}; }
+  // Cells added going from level `from` up to level `to`.
+  std::span<const P> added(int from, int to) const {
+    return {cells.data() + end[from], end[to] - end[from]};
+  }
+};
+
+// Tables are built once per (cols, rows) and shared read-only while anyone
+// holds them, so a new game or a level change never rebuilds a layout. The
+// cache keeps only weak references; a size nobody plays any more is freed.
+std::shared_ptr<const WallTable> wall_table(int cols, int rows);